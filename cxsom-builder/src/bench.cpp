@@ -0,0 +1,227 @@
+// The bench follows the computation from the instances getting ready
+// (see cxsom::subscribe). Its queue must not drop any of them.
+#define cxsom_SUBSCRIBE_QUEUE_CAPACITY (1 << 20)
+
+#include <cxsom-builder.hpp>
+#include <cxsom-processor.hpp>
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cstdlib>
+#include <optional>
+#include <memory>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = nullptr;
+cxsom::Monitor* cxsom::monitor = nullptr;
+
+#define CACHE      2
+#define FORGET     0
+#define OPENED  true
+
+using namespace cxsom::rules;
+context* cxsom::rules::ctx = nullptr;
+
+// The rules of a synthetic architecture. Each map has nb_externals
+// random inputs and nb_contextuals contextual layers, reading the
+// next maps (circularly).
+void declare_architecture(const std::vector<std::string>& rules_argv,
+			  unsigned int nb_maps, unsigned int map_dim, unsigned int side, unsigned int input_dim,
+			  unsigned int nb_externals, unsigned int nb_contextuals, unsigned int nb_timesteps) {
+  context c(rules_argv.begin(), rules_argv.end());
+
+  kwd::parameters p_main, p_match, p_learn, p_learn_e, p_learn_c, p_external, p_contextual, p_global;
+  p_main       | kwd::use("walltime", nb_timesteps - 1), kwd::use("epsilon", 0);
+  p_match      | p_main, kwd::use("sigma", .2);
+  p_learn      | p_main, kwd::use("alpha", .05);
+  p_learn_e    | p_learn, kwd::use("r", .25 );
+  p_learn_c    | p_learn, kwd::use("r", .075);
+  p_external   | p_main;
+  p_contextual | p_main;
+  p_global     | p_main, kwd::use("random-bmu", 1), kwd::use("sigma", .01), kwd::use("beta", .5), kwd::use("delta", .01), kwd::use("deadline", 100);
+
+  auto map_settings = cxsom::builder::map::make_settings();
+  map_settings.map_size            = side;
+  map_settings.cache_size          = CACHE;
+  map_settings.internals_file_size = FORGET;
+  map_settings.weights_file_size   = nb_timesteps;
+  map_settings.bmu_file_size       = nb_timesteps;
+  map_settings.kept_opened         = OPENED;
+  map_settings                     = {p_external, p_contextual, p_global};
+
+  std::string input_type = "Scalar";
+  if(input_dim > 1) input_type = std::string("Array=") + std::to_string(input_dim);
+
+  auto archi = cxsom::builder::architecture();
+  std::vector<cxsom::builder::ref_map> maps;
+  for(unsigned int m = 0; m < nb_maps; ++m) {
+    if(map_dim == 1) maps.push_back(cxsom::builder::map::make_1D(std::string("M") + std::to_string(m)));
+    else             maps.push_back(cxsom::builder::map::make_2D(std::string("M") + std::to_string(m)));
+  }
+
+  for(unsigned int m = 0; m < nb_maps; ++m) {
+    for(unsigned int e = 0; e < nb_externals; ++e) {
+      auto input = cxsom::builder::variable("in", cxsom::builder::name(std::string("M") + std::to_string(m)) / (std::string("x") + std::to_string(e)),
+					    input_type, CACHE, FORGET, OPENED);
+      input->definition();
+      kwd::var(input->timeline, input->varname) << fx::random() | p_main;
+      maps[m]->external(input, fx::match_gaussian, p_match, fx::learn_triangle, p_learn_e);
+    }
+    for(unsigned int c = 1; c <= nb_contextuals; ++c)
+      maps[m]->contextual(maps[(m + c) % nb_maps], fx::match_gaussian, p_match, fx::learn_triangle, p_learn_c);
+    archi << maps[m];
+  }
+  *archi = map_settings;
+
+  archi->relax_count = "Cvg";
+  archi->realize();
+  for(auto& map : maps) map->internals_random_at(0);
+} // The rules are sent to the processor here, when c is destroyed.
+
+double percentile(std::vector<double> values, double p) {
+  if(values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  return values[std::min(values.size() - 1, std::size_t(p * values.size()))];
+}
+
+int main(int argc, char* argv[]) {
+  if(argc != 10) {
+    std::cout << "Usage : " << argv[0] << " <root-dir> <nb-workers> <nb-maps> <1|2> <side> <input-dim> <nb-externals> <nb-contextuals> <nb-timesteps>" << std::endl
+	      << std::endl
+	      << "The synthetic architecture is made of nb-maps maps (1D or 2D, side units per dimension)." << std::endl
+	      << "Each map has nb-externals random inputs of dimension input-dim, and nb-contextual contextual" << std::endl
+	      << "layers reading the next maps. It runs in this process, with nb-workers workers, until" << std::endl
+	      << "nb-timesteps timesteps are done. The results are printed in JSON." << std::endl
+	      << "Execute : rm -rf <root-dir> afterwards." << std::endl;
+    return 0;
+  }
+
+  std::string  root_dir       =           argv[1] ;
+  unsigned int nb_workers     = std::stoul(argv[2]);
+  unsigned int nb_maps        = std::stoul(argv[3]);
+  unsigned int map_dim        = std::stoul(argv[4]);
+  unsigned int side           = std::stoul(argv[5]);
+  unsigned int input_dim      = std::stoul(argv[6]);
+  unsigned int nb_externals   = std::stoul(argv[7]);
+  unsigned int nb_contextuals = std::min(std::stoul(argv[8]), (unsigned long)(nb_maps - 1));
+  unsigned int nb_timesteps   = std::stoul(argv[9]);
+
+  fs::create_directories(root_dir);
+
+  std::random_device rd;
+  cxsom::jobs::UpdateFactory update_factory;
+  cxsom::jobs::fill(update_factory);
+  cxsom::jobs::TypeChecker type_checker;
+  cxsom::jobs::fill(type_checker);
+  cxsom::data::Center data_center(root_dir, cxsom_NB_IO_THREADS, cxsom_WRITE_QUEUE_CAPACITY);
+  cxsom::jobs::Center jobs_center(rd, update_factory, type_checker, data_center, nullptr);
+
+  for(unsigned int w = 0; w < nb_workers; ++w)
+    std::thread([&jobs_center](){jobs_center.worker_thread();}).detach();
+
+  // The rules are sent through the protocol, as a processor
+  // receives them, on a local port chosen by the system.
+  asio::io_service        ios;
+  asio::ip::tcp::acceptor acceptor(ios, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  std::thread([&data_center, &jobs_center, &acceptor]() {
+      while(true) std::thread(cxsom::processor::ServiceThread(data_center, jobs_center, acceptor)).detach();
+    }).detach();
+
+  // The instances getting ready are notified from now, so that no
+  // timestep is missed.
+  auto subscriber = std::make_shared<cxsom::subscribe::Subscriber>("", "", false);
+  cxsom::subscribe::Hub::get().add(subscriber);
+
+  // The computation starts when the last update is received, at the
+  // end of the sending.
+  auto setup_start = std::chrono::steady_clock::now();
+  declare_architecture({argv[0], "send", "localhost", std::to_string(acceptor.local_endpoint().port())},
+		       nb_maps, map_dim, side, input_dim, nb_externals, nb_contextuals, nb_timesteps);
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> setup = start - setup_start;
+
+  // A timestep is done when all the weights are computed.
+  std::size_t nb_weights = 0;
+  data_center.for_each_stats([&nb_weights](const cxsom::symbol::Variable& var, const auto&) {
+      if(var.timeline == "wgt") ++nb_weights;
+    });
+
+  // A timestep starts when its first instance gets ready. The inputs
+  // are not considered, since they do not depend on anything and they
+  // may be computed well ahead. The latency of a timestep is the
+  // time from its start to its end.
+  using clock = std::chrono::steady_clock;
+  std::vector<std::optional<clock::time_point>> starts(nb_timesteps);
+  std::vector<std::size_t>                      nb_ready(nb_timesteps, 0);
+  std::vector<double>                           latencies;
+  std::vector<cxsom::subscribe::Event>          events;
+  auto last = start;
+  while(latencies.size() < nb_timesteps) {
+    events.clear();
+    if(subscriber->pop(events) > 0) {
+      std::cerr << "Instance notifications have been dropped, the bench cannot follow the timesteps." << std::endl;
+      std::quick_exit(1);
+    }
+    auto now = clock::now();
+    for(auto& e : events) {
+      auto at = e.who.at;
+      if(at >= nb_timesteps || e.who.variable.timeline == "in") continue;
+      if(!starts[at]) starts[at] = now;
+      if(e.who.variable.timeline == "wgt" && ++nb_ready[at] == nb_weights) {
+	latencies.push_back(std::chrono::duration<double, std::milli>(now - *starts[at]).count());
+	last = now;
+      }
+    }
+  }
+  cxsom::subscribe::Hub::get().remove(subscriber);
+  std::chrono::duration<double> elapsed = last - start;
+  data_center.flush();
+
+  std::vector<double> relaxations;
+  for(unsigned int t = 1; t < nb_timesteps; ++t) {
+    auto cvg = data_center[cxsom::symbol::Instance("rlx", "Cvg", t)];
+    if(cvg->get_status() == cxsom::data::Availability::Ready)
+      cvg->get([&relaxations](auto, auto, auto& data) {relaxations.push_back(static_cast<const cxsom::data::Scalar&>(data).value);});
+  }
+
+  std::uint64_t bytes_read = 0, bytes_written = 0;
+  data_center.for_each_stats([&bytes_read, &bytes_written](const auto&, const cxsom::stats::Variable& v) {
+      bytes_read    += v.bytes_read;
+      bytes_written += v.bytes_written;
+    });
+
+  double relax_mean = 0, relax_min = 0, relax_max = 0;
+  if(!relaxations.empty()) {
+    relax_mean = std::accumulate(relaxations.begin(), relaxations.end(), 0.) / relaxations.size();
+    relax_min  = *std::min_element(relaxations.begin(), relaxations.end());
+    relax_max  = *std::max_element(relaxations.begin(), relaxations.end());
+  }
+
+  std::cout << "{" << std::endl
+	    << "  \"architecture\": {\"maps\": " << nb_maps << ", \"dim\": " << map_dim << ", \"side\": " << side
+	    << ", \"input_dim\": " << input_dim << ", \"externals\": " << nb_externals << ", \"contextuals\": " << nb_contextuals << "}," << std::endl
+	    << "  \"workers\": " << nb_workers << ',' << std::endl
+	    << "  \"timesteps\": " << nb_timesteps << ',' << std::endl
+	    << "  \"setup\": " << setup.count() << ',' << std::endl
+	    << "  \"duration\": " << elapsed.count() << ',' << std::endl
+	    << "  \"timesteps_per_second\": " << nb_timesteps / elapsed.count() << ',' << std::endl
+	    << "  \"latency_ms\": {\"p50\": " << percentile(latencies, .5) << ", \"p90\": " << percentile(latencies, .9)
+	    << ", \"p99\": " << percentile(latencies, .99) << ", \"max\": " << percentile(latencies, 1) << "}," << std::endl
+	    << "  \"relaxation\": {\"mean\": " << relax_mean << ", \"min\": " << relax_min << ", \"max\": " << relax_max << "}," << std::endl
+	    << "  \"io\": {\"bytes_read\": " << bytes_read << ", \"bytes_written\": " << bytes_written << "}" << std::endl
+	    << "}" << std::endl;
+
+  // The workers never end.
+  std::quick_exit(0);
+}
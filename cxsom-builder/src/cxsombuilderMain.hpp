@@ -32,6 +32,7 @@ namespace cxsom {
       std::size_t cache_size;
       std::size_t file_size;
       bool        kept_opened;
+      bool        in_memory = false; //!< If true, the variable has no file (file_size and kept_opened are ignored).
       Variable(const std::string& timeline,
 	       const name&        varname,
 	       const std::string& type,
@@ -42,7 +43,10 @@ namespace cxsom {
 	  timeline(timeline), varname(varname), type(type), cache_size(cache_size), file_size(file_size), kept_opened(kept_opened) {}
       
       void definition() const {
-	kwd::type(var(), type, cache_size, file_size, kept_opened);
+	if(in_memory)
+	  kwd::in_memory_type(var(), type, cache_size);
+	else
+	  kwd::type(var(), type, cache_size, file_size, kept_opened);
       }
 
       kwd::data var() const {return kwd::var(timeline, varname);}
@@ -70,6 +74,7 @@ namespace cxsom {
       bool         kept_opened;
       unsigned int at;
       bool         full_record;
+      bool         in_memory; //!< Without full record, the internal variables are kept in memory, with no file.
       mutable bool external_prefix_mode = false;
 
       const std::string& prefix() const {
@@ -80,8 +85,8 @@ namespace cxsom {
       AnalysisContext(const std::string& external_prefix, const std::string& internal_prefix,
 		      std::size_t cache_size, std::size_t file_size,
 		      bool kept_opened, unsigned int at,
-		      bool full_record)
-	: external_prefix(external_prefix), internal_prefix(internal_prefix), cache_size(cache_size), file_size(file_size), kept_opened(kept_opened), at(at), full_record(full_record) {}
+		      bool full_record, bool in_memory = false)
+	: external_prefix(external_prefix), internal_prefix(internal_prefix), cache_size(cache_size), file_size(file_size), kept_opened(kept_opened), at(at), full_record(full_record), in_memory(in_memory) {}
       
       std::shared_ptr<Variable> operator()(std::shared_ptr<Variable> var) const {
 	return variable(prefix() + "-" + var->timeline,
@@ -91,8 +96,10 @@ namespace cxsom {
       std::shared_ptr<Variable> operator[](std::shared_ptr<Variable> var) const {
 	std::size_t f_size = 0;
 	if(full_record) f_size = file_size;
-	return variable(prefix() + "-" + var->timeline,
-			var->varname, var->type, cache_size, f_size, kept_opened);
+	auto res = variable(prefix() + "-" + var->timeline,
+			    var->varname, var->type, cache_size, f_size, kept_opened);
+	res->in_memory = !full_record && in_memory;
+	return res;
       }
 
       void operator=(LayerKind k) const {
@@ -14,7 +14,7 @@ if len(sys.argv) < 4:
     
 root_dir = sys.argv[1]
 hostname = sys.argv[2]
-port     = int(sys.argv[3])
+port     = sys.argv[3]
 x_var_path = cx.variable.path_from(root_dir, 'input', 'X')
 y_var_path = cx.variable.path_from(root_dir, 'input', 'Y')
           
@@ -17,7 +17,7 @@ if len(sys.argv) < 6:
 conversion = {'A': 0., 'B': .2, 'C': .4, 'D': .6, 'E': .8, 'F': 1.}
 root_dir  = sys.argv[1]
 hostname  = sys.argv[2]
-port      = int(sys.argv[3])
+port      = sys.argv[3]
 seq       = [conversion[c] for c in sys.argv[4]]
 nb_times  = int(sys.argv[5])
 
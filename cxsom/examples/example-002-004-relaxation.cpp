@@ -14,9 +14,9 @@ context* cxsom::rules::ctx = nullptr;
 // variables in the relax timeline to get stabilized. We do not need
 // to store the values, except the countings. To implement this, we
 // use the variables only in the cache (1-sized cache is enough here),
-// but 0 filesize is used to avoid saving intermediate values.
+// and they are declared as in memory variables, so that they do not
+// even have a file.
 
-#define FORGET          0 // 0-sized filebuf stores no data history on the disk (computation is forgotten).
 #define KEEP_TRACE   1000 // We keep at most the 1000 last samples.
 #define CACHE_SIZE      1 // This is the number of time instants kept in memory for each variable.
 
@@ -26,9 +26,9 @@ int main(int argc, char* argv[]) {
   {
     timeline t("init");
 
-    kwd::type("A", "Map1D<Scalar>=1", CACHE_SIZE, FORGET, true);
-    kwd::type("B", "Map1D<Scalar>=1", CACHE_SIZE, FORGET, true);
-    kwd::type("C", "Map1D<Scalar>=1", CACHE_SIZE, FORGET, true);
+    kwd::in_memory_type("A", "Map1D<Scalar>=1", CACHE_SIZE);
+    kwd::in_memory_type("B", "Map1D<Scalar>=1", CACHE_SIZE);
+    kwd::in_memory_type("C", "Map1D<Scalar>=1", CACHE_SIZE);
 
     "A" << fx::random()                                                         | kwd::use("walltime", WALLTIME);
     "B" << fx::random()                                                         | kwd::use("walltime", WALLTIME);
@@ -41,9 +41,9 @@ int main(int argc, char* argv[]) {
     kwd::data A =  "A";
     kwd::data B =  "B";
     kwd::data C =  "C";
-    kwd::type(A,     kwd::type_of({"init", "A"}), CACHE_SIZE,     FORGET, true);
-    kwd::type(B,     kwd::type_of({"init", "B"}), CACHE_SIZE,     FORGET, true);
-    kwd::type(C,     kwd::type_of({"init", "C"}), CACHE_SIZE,     FORGET, true);
+    kwd::in_memory_type(A, kwd::type_of({"init", "A"}), CACHE_SIZE);
+    kwd::in_memory_type(B, kwd::type_of({"init", "B"}), CACHE_SIZE);
+    kwd::in_memory_type(C, kwd::type_of({"init", "C"}), CACHE_SIZE);
     kwd::type("Cvg", "Scalar",                    CACHE_SIZE, KEEP_TRACE, true);
 
     A <= fx::copy({"init", "A"});
@@ -42,21 +42,20 @@ cxsom::Monitor*  cxsom::monitor = nullptr;
 
 int main(int argc, char* argv[]) try {
   if(argc != 4 && argc != 6) {
-    std::cout << "Usage : " << argv[0] << " <root-dir> <nb_threads> <port> [<xrsw-hostname> <xrsw-port>]" << std::endl;
+    std::cout << "Usage : " << argv[0] << " <root-dir> <nb_threads> <port|unix:/path> [<xrsw-hostname> <xrsw-port|unix:/path>]" << std::endl;
     return 0;
   }
 
   std::string root_dir =           argv[1] ;
   int nb_threads       = std::stoi(argv[2]);
-  int port             = std::stoi(argv[3]);
+  std::string port     =           argv[3] ;
 
   // This is for supporting skednet scheduling feature.
   std::shared_ptr<sked::net::scope::xrsw::write_explicit> xrsw_writer;
-  asio::ip::tcp::iostream socket;
+  std::unique_ptr<std::iostream> socket;
   if(argc == 6) {
-    socket.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
-    socket.connect(argv[4], argv[5]);
-    xrsw_writer = std::make_shared<sked::net::scope::xrsw::write_explicit>(socket, socket);
+    socket = cxsom::endpoint::connect(argv[4], argv[5]);
+    xrsw_writer = std::make_shared<sked::net::scope::xrsw::write_explicit>(*socket, *socket);
   }
 
 #ifdef cxsomDEBUG_PROTOCOL
@@ -7,10 +7,12 @@ cxsom::Log*      cxsom::logger  = nullptr;
 cxsom::Monitor*  cxsom::monitor = nullptr;
 
 #include <set>
+#include <deque>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
 #include <utility>
+#include <thread>
 
 #include <filesystem>
 namespace fs = std::filesystem;
@@ -36,10 +38,15 @@ int main(int argc, char* argv[]) {
 
   std::string root_dir = argv[1];
 
+  // The manifest, if it is up to date, saves the crawling of the directories.
   std::set<fs::path> var_paths;
-  for(auto& elem: fs::recursive_directory_iterator(root_dir))
-    if(auto p = elem.path(); p.extension() == ".var")
-      var_paths.insert(p);
+  if(cxsom::data::Manifest manifest(root_dir); manifest.load())
+    for(auto& [var, entry] : manifest.variables())
+      var_paths.insert(fs::path(root_dir) / var.timeline / (var.name + ".var"));
+  else
+    for(auto& elem: fs::recursive_directory_iterator(root_dir))
+      if(auto p = elem.path(); p.extension() == ".var")
+	var_paths.insert(p);
   
   auto prefix_length = cxsom::symbol::parse::root_dir_length(root_dir);
   
@@ -50,23 +57,35 @@ int main(int argc, char* argv[]) {
   std::size_t inf_time_width   = 0;
   std::size_t sup_time_width   = 0;
 
-  std::vector<cxsom::data::File> files;
+  std::deque<cxsom::data::File> files; // Files cannot be moved.
   std::vector<std::pair<cxsom::symbol::Variable, std::string>> errors;
   for(auto& p : var_paths) {
     auto [tl, name] = cxsom::symbol::parse::split_varpath(prefix_length, p);
     if(tl == "")
       throw std::runtime_error("No timeline here.");
+    files.emplace_back(root_dir, cxsom::symbol::Variable(tl, name));
+  }
 
-    auto& file = files.emplace_back(root_dir, cxsom::symbol::Variable(tl, name));
-    try {
-      file.realize(nullptr, std::nullopt, std::nullopt, false);
+  // Reading the headers of the files is what takes time, it is done in parallel.
+  std::vector<std::string> realization_errors(files.size());
+  cxsom::data::parallel_for(files.size(), std::thread::hardware_concurrency(), [&files, &realization_errors](std::size_t i) {
+      try {
+	files[i].realize(nullptr, std::nullopt, std::nullopt, false);
+      }
+      catch(std::exception& e) {
+	realization_errors[i] = e.what();
+      }
+    });
+  
+  for(std::size_t i = 0; i < files.size(); ++i) {
+    auto& file = files[i];
+    if(realization_errors[i] == "") {
       if(auto l = file.type_as_string().size();                 l > type_width)       type_width       = l;
       if(auto l = std::to_string(file.get_file_size()).size();  l > file_size_width)  file_size_width  = l;
       if(auto l = std::to_string(file.get_cache_size()).size(); l > cache_size_width) cache_size_width = l;
     }
-    catch(std::exception& e) {
-      errors.push_back({{tl, name}, std::string("realization raised an exception: ") + e.what()});
-    }
+    else
+      errors.push_back({file, std::string("realization raised an exception: ") + realization_errors[i]});
 
     {
       auto [inf, sup] = file.get_time_range();
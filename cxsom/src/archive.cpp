@@ -0,0 +1,54 @@
+#include <cxsom-server.hpp>
+#include <cxsomArchive.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*     cxsom::ticker  = nullptr;
+cxsom::Log*      cxsom::logger  = nullptr;
+cxsom::Monitor*  cxsom::monitor = nullptr;
+
+#include <set>
+#include <iostream>
+#include <string>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+int main(int argc, char* argv[]) {
+  if(argc != 3) {
+    std::cout << "Usage : " << argv[0] << " <cxsom-simulation-rootdir> <archive-rootdir>" << std::endl
+	      << "  This writes a .vca columnar archive in <archive-rootdir> for each .var file of <cxsom-simulation-rootdir>." << std::endl
+	      << "  Variables should not be modified by a running processor meanwhile." << std::endl;
+    return 0;
+  }
+
+  std::string root_dir    = argv[1];
+  std::string archive_dir = argv[2];
+
+  std::set<fs::path> var_paths;
+  for(auto& elem: fs::recursive_directory_iterator(root_dir))
+    if(auto p = elem.path(); p.extension() == ".var")
+      var_paths.insert(p);
+  
+  auto prefix_length = cxsom::symbol::parse::root_dir_length(root_dir);
+
+  int status = 0;
+  for(auto& p : var_paths) {
+    auto [tl, name] = cxsom::symbol::parse::split_varpath(prefix_length, p);
+    if(tl == "") {
+      std::cerr << "Skipping " << p << ": no timeline here." << std::endl;
+      continue;
+    }
+    cxsom::symbol::Variable var(tl, name);
+    try {
+      auto nb_ready = cxsom::data::Archive::build(root_dir, archive_dir, var);
+      std::cout << var << " : " << nb_ready << " ready instances archived." << std::endl;
+    }
+    catch(std::exception& e) {
+      std::cerr << "\e[91mError : " << var << ": " << e.what() << "\e[0m" << std::endl;
+      status = 1;
+    }
+  }
+  
+  return status;
+}
@@ -5,26 +5,151 @@
 #include <thread>
 #include <string>
 #include <memory>
+#include <vector>
+#include <chrono>
 #include <stdexcept>
+#include <map>
+#include <mutex>
+#include <limits>
+#include <optional>
+#include <filesystem>
 
 #include <utility> // should be included by asio
 #include <asio.hpp>
 
+#include <cerrno>
+#include <sys/socket.h>
+
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 
 #include <skednet.hpp>
 #include <cxsom-server.hpp>
+#include <cxsomRecord.hpp>
+#include <cxsomEndpoint.hpp>
+
+// Ready instances are written into the files by these I/O threads,
+// through a queue of bounded capacity, so that computing threads do
+// not wait for the disk. With 0 (the default), they are written when
+// they get ready, so that external readers (pycxsom, viewers...) see
+// them in the files as soon as possible.
+#ifndef cxsom_NB_IO_THREADS
+#define cxsom_NB_IO_THREADS 0
+#endif
+#ifndef cxsom_WRITE_QUEUE_CAPACITY
+#define cxsom_WRITE_QUEUE_CAPACITY 4096
+#endif
+
+// The variables of the root directory are known from its manifest
+// (see data::Manifest), which is rebuilt by that many threads when it
+// is stale. 0 disables the manifest.
+#ifndef cxsom_MANIFEST_SCAN_THREADS
+#define cxsom_MANIFEST_SCAN_THREADS 8
+#endif
+
+// The files of the watched variables (see processor::Watcher) are
+// polled with this period (ms).
+#ifndef cxsom_WATCH_PERIOD_MS
+#define cxsom_WATCH_PERIOD_MS 100
+#endif
+
+// When no instance gets ready, the connection of a subscriber is
+// checked with this period (ms), so that it ends when the client is
+// gone.
+#ifndef cxsom_SUBSCRIBE_PROBE_PERIOD_MS
+#define cxsom_SUBSCRIBE_PROBE_PERIOD_MS 1000
+#endif
 
 namespace cxsom {
   namespace processor {
 
+    /**
+     * The files of the watched variables are polled. When one of them
+     * is modified, the processor is notified as with the notify
+     * command. The writings of the processor itself are noticed as
+     * well, which only costs a useless check.
+     */
+    class Watcher {
+    private:
+
+      std::mutex mutex;
+      std::map<symbol::Variable, std::optional<fs::file_time_type>> watched;
+      data::Center* data_center = nullptr;
+      jobs::Center* jobs_center = nullptr;
+      bool started = false;
+
+      Watcher() = default;
+
+      void poll() {
+	while(true) {
+	  std::this_thread::sleep_for(std::chrono::milliseconds(cxsom_WATCH_PERIOD_MS));
+	  std::vector<symbol::Variable> modified;
+	  {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    for(auto& [var, last] : watched) {
+	      std::error_code ec;
+	      auto t = fs::last_write_time(data_center->path_of(var), ec);
+	      if(ec || t == last) continue;
+	      last = t;
+	      modified.push_back(var);
+	    }
+	  }
+	  for(auto& var : modified)
+	    try {
+	      jobs_center->notify_written(var, 0, std::numeric_limits<std::size_t>::max());
+	    }
+	    catch(const std::exception& e) {
+	      std::cout << "Watching " << var << " : " << e.what() << std::endl;
+	    }
+	}
+      }
+
+    public:
+
+      /**
+       * The watcher lives as long as the process, as the centers.
+       */
+      static Watcher& get() {
+	static Watcher* watcher = new Watcher();
+	return *watcher;
+      }
+
+      void watch(const symbol::Variable& var, data::Center& data, jobs::Center& jobs) {
+	std::lock_guard<std::mutex> lock(mutex);
+	data_center = &data;
+	jobs_center = &jobs;
+	watched.try_emplace(var, std::nullopt);
+	if(!started) {
+	  started = true;
+	  std::thread([this](){this->poll();}).detach();
+	}
+      }
+
+      void unwatch(const symbol::Variable& var) {
+	std::lock_guard<std::mutex> lock(mutex);
+	watched.erase(var);
+      }
+    };
+
     class ServiceThread {
     private:
 
       cxsom::data::Center& data_center;
       cxsom::jobs::Center& jobs_center;
-      std::shared_ptr<asio::ip::tcp::iostream>  p_socket;
+      std::shared_ptr<std::iostream>            p_socket;
+      std::streambuf*                           sbuf; // The socket buffer, not recorded.
+      std::shared_ptr<record::Tee>              tee;  // In front of sbuf while recording is active.
+      int                                       native_socket = -1;
+
+      // This reads ahead, without consuming anything, whether the
+      // client has closed the connection (or at least its sending
+      // side).
+      bool peer_closed() const {
+	char c;
+	auto nb = ::recv(native_socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+	return nb == 0 || (nb < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+      }
 
       void process_ping() {
 #ifdef cxsomDEBUG_PROTOCOL
@@ -59,6 +184,367 @@ namespace cxsom {
 #endif
       }
   
+      // stats
+      // The answer is "ok <n>" followed by n lines, each one starting
+      // with the kind of information it gives.
+      void process_stats() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_stats() >>>>" << std::endl;
+#endif
+	auto& registry = stats::Registry::get();
+	std::vector<std::string> lines;
+	auto uptime = registry.uptime();
+	auto seconds = [](std::uint64_t ns) {return ns * 1e-9;};
+	{
+	  std::ostringstream ostr;
+	  ostr << "uptime " << uptime;
+	  lines.push_back(ostr.str());
+	}
+	registry.for_each_worker([&lines, &seconds](std::size_t id, const stats::Worker& w) {
+	    std::chrono::duration<double> alive = std::chrono::steady_clock::now() - w.origin;
+	    std::ostringstream ostr;
+	    ostr << "worker " << id << " tasks " << w.nb_tasks << " busy " << seconds(w.busy)
+		 << " utilization " << seconds(w.busy) / alive.count()
+		 << " scheduling " << seconds(w.scheduling) << " idle " << seconds(w.idle);
+	    lines.push_back(ostr.str());
+	  });
+	registry.for_each_lock([&lines, &seconds](const std::string& name, const stats::Lock& l) {
+	    std::ostringstream ostr;
+	    ostr << "lock " << name << " acquisitions " << l.acquisitions << " contended " << l.contended
+		 << " waiting " << seconds(l.waiting);
+	    lines.push_back(ostr.str());
+	  });
+	registry.for_each_operation([&lines, &seconds](const std::string& name, const stats::Operation& op) {
+	    std::ostringstream ostr;
+	    ostr << "operation " << name << " tasks " << op.nb_tasks << " time " << seconds(op.duration) << " histogram";
+	    std::size_t last = op.histogram.size();
+	    while(last > 1 && op.histogram[last - 1] == 0) --last;
+	    for(std::size_t b = 0; b < last; ++b) ostr << ' ' << op.histogram[b];
+	    lines.push_back(ostr.str());
+	  });
+	{
+	  auto& gauges = registry.timesteps;
+	  std::int64_t live = 0;
+	  for(auto& c : gauges.count) live += c;
+	  std::ostringstream ostr;
+	  ostr << "timesteps live " << live << " blocked " << gauges.count[timestep::status_index(timestep::Status::Blocked)];
+	  lines.push_back(ostr.str());
+	  for(auto status : {timestep::Status::Unbound, timestep::Status::Blocked, timestep::Status::Relaxing, timestep::Status::Checking, timestep::Status::Done}) {
+	    auto s = timestep::status_index(status);
+	    std::ostringstream ostr;
+	    ostr << "status " << status << " timesteps " << gauges.count[s];
+	    for(auto queue : {timestep::Queue::Unstable, timestep::Queue::Impossible, timestep::Queue::Stable, timestep::Queue::Confirmed, timestep::Queue::New})
+	      ostr << ' ' << queue << ' ' << gauges.depth[s][static_cast<unsigned int>(queue)];
+	    lines.push_back(ostr.str());
+	  }
+	}
+	std::uint64_t hits = 0, misses = 0;
+	data_center.for_each_stats([&lines, &hits, &misses](const symbol::Variable& var, const stats::Variable& v) {
+	    hits   += v.hits;
+	    misses += v.misses;
+	    std::ostringstream ostr;
+	    ostr << "variable " << var.timeline << '/' << var.name << " hits " << v.hits << " misses " << v.misses
+		 << " read " << v.bytes_read << " written " << v.bytes_written;
+	    lines.push_back(ostr.str());
+	  });
+	{
+	  std::ostringstream ostr;
+	  ostr << "cache hits " << hits << " misses " << misses << " rate " << (hits + misses > 0 ? hits / double(hits + misses) : 0.);
+	  lines.push_back(ostr.str());
+	}
+	
+	*p_socket << "ok " << lines.size() << '\n';
+	for(auto& line : lines) *p_socket << line << '\n';
+	*p_socket << std::flush;
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_stats <<<<" << std::endl;
+#endif
+      }
+
+      // trace on
+      // trace off <path>
+      // Tracing is switched at runtime, the events recorded so far
+      // are written in <path> (Chrome trace format) when it stops.
+      void process_trace() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_trace() >>>>" << std::endl;
+#endif
+	std::string buf;
+	std::getline(*p_socket, buf);
+	std::istringstream socket(buf);
+	std::string mode;
+	socket >> mode;
+	if(mode == "on") {
+	  trace::Tracer::get().start();
+	  *p_socket << "ok" << std::endl;
+	}
+	else if(mode == "off") {
+	  trace::Tracer::get().stop();
+	  std::string path;
+	  socket >> std::ws;
+	  std::getline(socket, path);
+	  std::ofstream file(path);
+	  if(!file)
+	    *p_socket << "error cannot write trace in \"" << path << "\"." << std::endl;
+	  else {
+	    trace::Tracer::get().write_chrome(file);
+	    *p_socket << "ok" << std::endl;
+	  }
+	}
+	else
+	  *p_socket << "error expecting \"on\" or \"off\", got \"" << mode << "\" instead." << std::endl;
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_trace <<<<" << std::endl;
+#endif
+      }
+
+      // record on <path>
+      // record off
+      // The received commands are written in <path> (see
+      // record::Recorder), cxsom-replay sends them again.
+      void process_record() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_record() >>>>" << std::endl;
+#endif
+	std::string buf;
+	std::getline(*p_socket, buf);
+	std::istringstream socket(buf);
+	std::string mode;
+	socket >> mode;
+	if(mode == "on") {
+	  std::string path;
+	  socket >> std::ws;
+	  std::getline(socket, path);
+	  if(record::Recorder::get().start(path))
+	    *p_socket << "ok" << std::endl;
+	  else
+	    *p_socket << "error cannot write capture in \"" << path << "\"." << std::endl;
+	}
+	else if(mode == "off") {
+	  record::Recorder::get().stop();
+	  *p_socket << "ok" << std::endl;
+	}
+	else
+	  *p_socket << "error expecting \"on\" or \"off\", got \"" << mode << "\" instead." << std::endl;
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_record <<<<" << std::endl;
+#endif
+      }
+  
+      // This consumes n bytes from the socket buffer, by bounded chunks.
+      void skip_payload(std::size_t n) {
+	char chunk[4096];
+	while(n > 0) {
+	  auto nb = static_cast<std::streamsize>(std::min(n, sizeof(chunk)));
+	  if(sbuf->sgetn(chunk, nb) != nb)
+	    throw std::ios_base::failure("feed : truncated payload.");
+	  n -= nb;
+	}
+      }
+  
+      // feed <timeline> <name> <first_at> <count> <nb_bytes>
+      // The line is followed by nb_bytes raw bytes, the values of the
+      // count instances from first_at, as they are stored in variable
+      // files. They are set by the processor, which re-tests the
+      // timesteps blocked by them, so no ping is needed.
+      void process_feed() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_feed() >>>>" << std::endl;
+#endif
+	std::string buf;
+	std::getline(*p_socket, buf);
+	std::istringstream socket(buf);
+	std::string timeline, name;
+	std::size_t first_at = 0, count = 0, nb_bytes = 0;
+	socket >> timeline >> name >> first_at >> count >> nb_bytes;
+
+	// The payload is read from the socket buffer, so that it is not
+	// recorded. It is consumed even if the feeding fails, in order
+	// to keep the connection usable, but it is only stored once its
+	// size is checked.
+	std::string error;
+	std::size_t length = 0;
+	symbol::Variable var(timeline, name);
+	if(!socket)
+	  error = std::string("expecting \"<timeline> <name> <first_at> <count> <nb_bytes>\", got \"") + buf + "\" instead.";
+	else
+	  try {
+	    length = data_center.type_of(var)->byte_length();
+	    if(length == 0 || nb_bytes % length != 0 || nb_bytes / length != count) {
+	      std::ostringstream ostr;
+	      ostr << count << " instance(s) of " << var << " are " << count * length << " bytes, got " << nb_bytes << '.';
+	      error = ostr.str();
+	    }
+	  }
+	  catch(const std::exception& e) {
+	    error = e.what();
+	  }
+
+	if(error != "") {
+#ifdef cxsomDEBUG_PROTOCOL
+	  std::cout << "!! " << error << std::endl;
+#endif
+	  skip_payload(nb_bytes);
+	  *p_socket << "error " << error << std::endl;
+	  return;
+	}
+	
+	std::vector<char> payload(nb_bytes);
+	if(sbuf->sgetn(payload.data(), nb_bytes) != static_cast<std::streamsize>(nb_bytes))
+	  throw std::ios_base::failure("feed : truncated payload.");
+
+	try {
+	  std::size_t nb_ready = 0;
+	  jobs_center.feed(timeline, first_at, count, [&]() {
+	      for(std::size_t i = 0; i < count; ++i)
+		data_center[symbol::Instance(var, first_at + i)]->set([&](auto& status, auto&, auto& data) {
+		    if(status == data::Availability::Ready) {++nb_ready; return;}
+		    data.read(payload.data() + i * length);
+		    status = data::Availability::Ready;
+		  });
+	    });
+#ifdef cxsomDEBUG_PROTOCOL
+	  std::cout << "-- fed " << count - nb_ready << " instance(s) of " << var << std::endl;
+#endif
+	  if(nb_ready == 0)
+	    *p_socket << "ok" << std::endl;
+	  else
+	    *p_socket << "error " << nb_ready << " instance(s) of " << var << " were already ready, they are left unchanged." << std::endl;
+	}
+	catch(const std::exception& e) {
+#ifdef cxsomDEBUG_PROTOCOL
+	  std::cout << "!! " << e.what() << std::endl;
+#endif
+	  *p_socket << "error " << e.what() << std::endl;
+	}
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_feed <<<<" << std::endl;
+#endif
+      }
+
+      // notify <timeline> <name>
+      // notify <timeline> <name> <from_at> <to_at>
+      // The instances of the variable (in [from_at, to_at] if given)
+      // may have been written in its file by some client. This is a
+      // ping restricted to the timesteps that wait for them.
+      void process_notify() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_notify() >>>>" << std::endl;
+#endif
+	std::string buf;
+	std::getline(*p_socket, buf);
+	std::istringstream socket(buf);
+	std::vector<std::string> words;
+	for(std::string w; socket >> w;) words.push_back(w);
+	if(words.size() != 2 && words.size() != 4) {
+	  *p_socket << "error expecting \"<timeline> <name> [<from_at> <to_at>]\", got \"" << buf << "\" instead." << std::endl;
+	  return;
+	}
+	try {
+	  std::size_t from_at = 0, to_at = std::numeric_limits<std::size_t>::max();
+	  if(words.size() == 4) {
+	    from_at = std::stoul(words[2]);
+	    to_at   = std::stoul(words[3]);
+	  }
+	  jobs_center.notify_written({words[0], words[1]}, from_at, to_at);
+	  *p_socket << "ok" << std::endl;
+	}
+	catch(const std::exception& e) {
+#ifdef cxsomDEBUG_PROTOCOL
+	  std::cout << "!! " << e.what() << std::endl;
+#endif
+	  *p_socket << "error " << e.what() << std::endl;
+	}
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_notify <<<<" << std::endl;
+#endif
+      }
+
+      // watch on <timeline> <name>
+      // watch off <timeline> <name>
+      // The file of a watched variable is polled, each modification
+      // is notified (see process_notify).
+      void process_watch() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_watch() >>>>" << std::endl;
+#endif
+	std::string buf;
+	std::getline(*p_socket, buf);
+	std::istringstream socket(buf);
+	std::string mode, timeline, name;
+	socket >> mode >> timeline >> name;
+	if((mode != "on" && mode != "off") || name == "")
+	  *p_socket << "error expecting \"on|off <timeline> <name>\", got \"" << buf << "\" instead." << std::endl;
+	else {
+	  if(mode == "on")
+	    Watcher::get().watch({timeline, name}, data_center, jobs_center);
+	  else
+	    Watcher::get().unwatch({timeline, name});
+	  *p_socket << "ok" << std::endl;
+	}
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_watch <<<<" << std::endl;
+#endif
+      }
+
+      // subscribe <notify|payload> [<timeline> [<name>]]
+      // After "ok", the connection streams a line "ready <timeline>
+      // <name> <at>" for each instance that gets ready, of the given
+      // timeline or variable if any. In payload mode, the line ends
+      // with the byte length of the value, whose bytes follow. A
+      // subscriber which is too slow loses events, a line "dropped
+      // <n>" tells it. The stream ends when the client disconnects or
+      // shuts down its sending side, false is returned then so that
+      // the connection is closed.
+      bool process_subscribe() {
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << ">> process_subscribe() >>>>" << std::endl;
+#endif
+	std::string buf;
+	std::getline(*p_socket, buf);
+	std::istringstream socket(buf);
+	std::string mode, timeline, name;
+	socket >> mode >> timeline >> name;
+	if(mode != "notify" && mode != "payload") {
+	  *p_socket << "error expecting \"notify\" or \"payload\", got \"" << mode << "\" instead." << std::endl;
+	  return true;
+	}
+	auto subscriber = std::make_shared<subscribe::Subscriber>(timeline, name, mode == "payload");
+	subscribe::Hub::get().add(subscriber);
+	*p_socket << "ok" << std::endl;
+
+	// The stream is written in the socket buffer, without the
+	// stream exceptions, since a disconnection is expected here.
+	std::vector<subscribe::Event> events;
+	bool connected = true;
+	while(connected) {
+	  events.clear();
+	  auto dropped = subscriber->pop(events, std::chrono::milliseconds(cxsom_SUBSCRIBE_PROBE_PERIOD_MS));
+	  if(events.empty() && dropped == 0) {
+	    connected = !peer_closed();
+	    continue;
+	  }
+	  std::ostringstream ostr;
+	  if(dropped > 0) ostr << "dropped " << dropped << '\n';
+	  for(auto& e : events) {
+	    ostr << "ready " << e.who.variable.timeline << ' ' << e.who.variable.name << ' ' << e.who.at;
+	    if(subscriber->with_payload) {
+	      ostr << ' ' << e.payload.size() << '\n';
+	      ostr.write(e.payload.data(), e.payload.size());
+	    }
+	    else
+	      ostr << '\n';
+	  }
+	  auto chunk = ostr.str();
+	  connected = sbuf->sputn(chunk.data(), chunk.size()) == static_cast<std::streamsize>(chunk.size()) && sbuf->pubsync() == 0;
+	}
+	subscribe::Hub::get().remove(subscriber);
+#ifdef cxsomDEBUG_PROTOCOL
+	std::cout << "-- process_subscribe <<<<" << std::endl;
+#endif
+	return false;
+      }
+
       void process_declare() {
 #ifdef cxsomDEBUG_PROTOCOL
 	std::string buf;
@@ -66,7 +552,7 @@ namespace cxsom {
 	std::istringstream socket(buf);
 	std::cout << ">> " << buf << " // process_declare(...) >>>>" << std::endl;
 #else
-	asio::ip::tcp::iostream& socket = *p_socket;
+	std::iostream& socket = *p_socket;
 #endif
 	try {
 	  auto v = cxsom::protocol::read::variable(socket);
@@ -81,13 +567,16 @@ namespace cxsom {
 	  else
 	    std::cout << " = ???" << std::endl;
 #endif
-	  auto [cache_size, file_size, kept_opened] = cxsom::protocol::read::storage(socket);
+	  auto [cache_size, file_size, kept_opened, in_memory] = cxsom::protocol::read::storage(socket);
 #ifdef cxsomDEBUG_PROTOCOL
 	  std::cout << "-- got cache_size  = " << cache_size << std::endl
 		    << "       file_size   = " << file_size << std::endl
-		    << "       kept_opened = " << std::boolalpha << kept_opened << std::endl;
+		    << "       kept_opened = " << std::boolalpha << kept_opened << std::endl
+		    << "       in_memory   = " << std::boolalpha << in_memory << std::endl;
 #endif
-	  if(cache_size > 0)
+	  if(in_memory)
+	    data_center.check(v, t, std::max(cache_size, std::size_t(1)), 0, false, true);
+	  else if(cache_size > 0)
 	    data_center.check(v, t, cache_size, file_size, kept_opened);
 	  else
 	    data_center.check(v, t, kept_opened);
@@ -129,7 +618,7 @@ namespace cxsom {
 #ifdef cxsomDEBUG_PROTOCOL
 	std::cout << ">>  // process_updates() >>>>" << std::endl;
 #endif
-	asio::ip::tcp::iostream& socket = *p_socket;
+	std::iostream& socket = *p_socket;
 	std::string command;
 	char c;
 	std::size_t number = nb_updates();
@@ -155,7 +644,7 @@ namespace cxsom {
 	std::istringstream socket(buf);
 	std::cout << ">> " << buf << "// process_static() >>>> " << std::endl;
 #else
-	asio::ip::tcp::iostream& socket = *p_socket;
+	std::iostream& socket = *p_socket;
 #endif
 	try {
 	  jobs_center += cxsom::protocol::read::update(socket);
@@ -182,7 +671,7 @@ namespace cxsom {
 	std::istringstream socket(buf);
 	std::cout << ">> " << buf << "// process_pattern() >>>> " << std::endl;
 #else
-	asio::ip::tcp::iostream& socket = *p_socket;
+	std::iostream& socket = *p_socket;
 #endif
 	try {
 	  jobs_center += cxsom::protocol::read::pattern::update(socket);
@@ -202,29 +691,57 @@ namespace cxsom {
 #endif
       }
 
+      // Reading through the tee costs a virtual call per character,
+      // so it is only set in front of the socket buffer while
+      // recording is active.
+      void follow_recording() {
+	std::streambuf* buf = sbuf;
+	if(record::active.load(std::memory_order_relaxed)) buf = tee.get();
+	if(p_socket->rdbuf() != buf) p_socket->rdbuf(buf);
+      }
+
     public:
 
+      /**
+       * The acceptor is a tcp or a local one (see cxsom::endpoint).
+       */
+      template<typename ACCEPTOR>
       ServiceThread(cxsom::data::Center& data_center,
 		    cxsom::jobs::Center& jobs_center,
-		    asio::ip::tcp::acceptor& acceptor) 
-	: data_center(data_center), jobs_center(jobs_center), p_socket(new asio::ip::tcp::iostream()) {
-	acceptor.accept(*(p_socket->rdbuf())); // Blocking is here
+		    ACCEPTOR& acceptor) 
+	: data_center(data_center), jobs_center(jobs_center) {
+	auto socket = std::make_shared<typename ACCEPTOR::protocol_type::iostream>();
+	acceptor.accept(*(socket->rdbuf())); // Blocking is here
+	sbuf          = socket->rdbuf();
+	native_socket = socket->socket().native_handle();
+	p_socket      = socket;
+	tee           = std::make_shared<record::Tee>(sbuf);
       }
       ServiceThread(const ServiceThread& cp) = default;
 
       void operator()() {
-	asio::ip::tcp::iostream& socket = *p_socket;
+	std::iostream& socket = *p_socket;
 	std::string command;
 	char c;
+	bool connected = true;
 	try {
 	  socket.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
-	  while(true) {
+	  while(connected) {
+	    socket >> std::ws; // The previous line is over, recording can be switched.
+	    follow_recording();
 	    socket >> command;
 	    socket.get(c);
 	    if     (command == "declare") process_declare();
 	    else if(command == "updates") process_updates();
 	    else if(command == "ping"   ) process_ping();
 	    else if(command == "clear"  ) process_clear();
+	    else if(command == "trace"  ) process_trace();
+	    else if(command == "stats"  ) process_stats();
+	    else if(command == "record" ) process_record();
+	    else if(command == "feed"   ) process_feed();
+	    else if(command == "notify" ) process_notify();
+	    else if(command == "watch"  ) process_watch();
+	    else if(command == "subscribe") connected = process_subscribe();
 	    else
 	      socket << "error command \"" << command << "\" not implemented." << std::endl;
 	  }
@@ -243,27 +760,39 @@ namespace cxsom {
 		       const cxsom::jobs::TypeChecker& checker,
 		       const std::string& root_dir,
 		       int nb_threads,
-		       int port,
+		       const std::string& port,
 		       std::shared_ptr<sked::net::scope::xrsw::write_explicit> xrsw_writer) {
       std::random_device rd;
-      cxsom::data::Center data_center(root_dir);
+      cxsom::data::Center data_center(root_dir, cxsom_NB_IO_THREADS, cxsom_WRITE_QUEUE_CAPACITY);
+      if(cxsom_MANIFEST_SCAN_THREADS > 0) data_center.use_manifest(cxsom_MANIFEST_SCAN_THREADS);
       cxsom::jobs::Center jobs_center(rd, factory, checker, data_center, xrsw_writer);
       
       std::vector<std::thread> workers;
       for(int i = 0; i < nb_threads; ++i)
 	workers.emplace_back([&jobs_center](){jobs_center.worker_thread();});
       
-      asio::io_service        ios;
-      asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
-      asio::ip::tcp::acceptor acceptor(ios, endpoint);
-      
-      while(true) {
-	std::thread service(ServiceThread(data_center, jobs_center, acceptor));
-	service.detach();
-      }
+      asio::io_service ios;
+      cxsom::endpoint::listen(ios, port, [&data_center, &jobs_center](auto& acceptor) {
+	while(true) {
+	  std::thread service(ServiceThread(data_center, jobs_center, acceptor));
+	  service.detach();
+	}
+      });
       
       for(auto& w : workers) w.join();
     }
 
+    /**
+     * The port is "unix:/path" for a local socket (see cxsom::endpoint).
+     */
+    inline void launch(const cxsom::jobs::UpdateFactory& factory,
+		       const cxsom::jobs::TypeChecker& checker,
+		       const std::string& root_dir,
+		       int nb_threads,
+		       int port,
+		       std::shared_ptr<sked::net::scope::xrsw::write_explicit> xrsw_writer) {
+      launch(factory, checker, root_dir, nb_threads, std::to_string(port), xrsw_writer);
+    }
+
   }
 }
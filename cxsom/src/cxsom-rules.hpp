@@ -148,6 +148,18 @@ inline void cxsom::rules::kwd::type(data d,
   type(d, t, 0, 0, kept_opened);
 }
 
+inline void cxsom::rules::kwd::in_memory_type(data d,
+					      const std::string& t,
+					      std::size_t cache_size) {
+  ctx->declare_type(d.id.key, t, cache_size, 0, false, true);
+}
+
+inline void cxsom::rules::kwd::in_memory_type(const std::vector<data> range,
+					      const std::string& t,
+					      std::size_t cache_size) {
+  for(auto& d : range) in_memory_type(d, t, cache_size);
+}
+
 inline std::string cxsom::rules::kwd::type_of(data d) {
   return ctx->type_of(d.id.key);
 }
@@ -251,8 +263,9 @@ inline void cxsom::rules::context::declare_type(value_key v,
 						const std::string& t,
 						std::size_t cache_size,
 						std::size_t file_size,
-						bool kept_opened) {
-  type_info info(t, cache_size, file_size, kept_opened);
+						bool kept_opened,
+						bool in_memory) {
+  type_info info(t, cache_size, file_size, kept_opened, in_memory);
   if(auto it = declared_types.find(v); it != declared_types.end()) {
     if(it->second != info) {
       std::ostringstream ostr;
@@ -584,7 +597,7 @@ inline void cxsom::rules::context::print_graph(std::ostream& file, std::map<valu
 
 
 
-inline void cxsom::rules::context::handle_answer(asio::ip::tcp::iostream& socket) {
+inline void cxsom::rules::context::handle_answer(std::iostream& socket) {
   std::string line;
   std::getline(socket, line, '\n');
 #ifdef cxsomDEBUG_PROTOCOL
@@ -602,18 +615,18 @@ inline void cxsom::rules::context::handle_answer(asio::ip::tcp::iostream& socket
 #endif
 }
 
-inline void cxsom::rules::context::send(const std::string& hostname, int port) {
-  asio::ip::tcp::iostream socket;
-  socket.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+inline void cxsom::rules::context::send(const std::string& hostname, const std::string& port) {
   try {
-    socket.connect(hostname, std::to_string(port));
+    auto p_socket = cxsom::endpoint::connect(hostname, port);
+    auto& socket = *p_socket;
 
     for(auto& kv : declared_types) {
       protocol::write::type_declaration(socket, kv.first,
 					cxsom::rules::type_of       (kv.second),
 					cxsom::rules::cache_size_of (kv.second),
 					cxsom::rules::file_size_of  (kv.second),
-					cxsom::rules::kept_opened_of(kv.second));
+					cxsom::rules::kept_opened_of(kv.second),
+					cxsom::rules::in_memory_of  (kv.second));
       socket << std::flush;
       handle_answer(socket);
     }
@@ -633,7 +646,6 @@ inline void cxsom::rules::context::send(const std::string& hostname, int port) {
       }
     }
     
-    socket.close();
   }		
   catch(std::exception& e) {
     std::cerr << "Exception caught : " << e.what() << " --> " << typeid(e).name()<< std::endl;
@@ -674,7 +686,7 @@ inline cxsom::rules::context::~context() {
 	      << "  " << argv[0] << " debug [-- ...]" << std::endl
 	      << "  " << argv[0] << " graph <file-prefix> [-- ...]" << std::endl
 	      << "  " << argv[0] << " graph-full <file-prefix> [-- ...]" << std::endl
-	      << "  " << argv[0] << " send  <hostname> <port> [-- ...]" << std::endl
+	      << "  " << argv[0] << " send  <hostname> <port|unix:/path> [-- ...]" << std::endl
 	      << std::endl
 	      << "Arguments following -- are supplementary arguments for user-define purpose."
 	      << std::endl;
@@ -715,11 +727,11 @@ inline cxsom::rules::context::~context() {
   else if(argv[1] == "send") {
     if(size(argv) < 4) {
       std::cout << "Usage :" << std::endl
-		<< "  " << argv[0] << " send <hostname> <port>" << std::endl;
+		<< "  " << argv[0] << " send <hostname> <port|unix:/path>" << std::endl;
       return;
     }
 
-    send(argv[2], std::stoi(argv[3]));
+    send(argv[2], argv[3]);
   }
   else {
     std::cout << "Invalid command \"" << argv[1] << "\", run without arguments to get help." << std::endl;
@@ -8,6 +8,8 @@
 #include <cxsomProtocolServer.hpp>
 #include <cxsomSymbols.hpp>
 #include <cxsomTimeStep.hpp>
+#include <cxsomTrace.hpp>
+#include <cxsomStats.hpp>
 #include <cxsomUpdate.hpp>
 #include <cxsomVariable.hpp>
 
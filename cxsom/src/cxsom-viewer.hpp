@@ -1,4 +1,5 @@
 #include <cxsomVariable.hpp>
+#include <cxsomArchive.hpp>
 
 /**
  * @example example-001-001-datafile.cpp
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <utility>
+#include <limits>
+
+#include <cxsomData.hpp>
+#include <cxsomSymbols.hpp>
+#include <cxsomVariable.hpp>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#define cxsom_ARCHIVE_VERSION                1
+#define cxsom_ARCHIVE_ALIGNMENT              64
+
+#define cxsom_OFFSET_VERSION_IN_ARCHIVE      (cxsom_LENGTH_TYPE_IN_FILE                                )
+#define cxsom_OFFSET_FIRST_TIME_IN_ARCHIVE   (cxsom_OFFSET_VERSION_IN_ARCHIVE      + cxsom_UINT_LENGTH)
+#define cxsom_OFFSET_NB_TIMES_IN_ARCHIVE     (cxsom_OFFSET_FIRST_TIME_IN_ARCHIVE   + cxsom_UINT_LENGTH)
+#define cxsom_OFFSET_BYTE_LENGTH_IN_ARCHIVE  (cxsom_OFFSET_NB_TIMES_IN_ARCHIVE     + cxsom_UINT_LENGTH)
+#define cxsom_OFFSET_READY_POS_IN_ARCHIVE    (cxsom_OFFSET_BYTE_LENGTH_IN_ARCHIVE  + cxsom_UINT_LENGTH)
+#define cxsom_OFFSET_PAYLOAD_POS_IN_ARCHIVE  (cxsom_OFFSET_READY_POS_IN_ARCHIVE    + cxsom_UINT_LENGTH)
+#define cxsom_OFFSET_HEADER_IN_ARCHIVE       128
+
+namespace cxsom {
+  namespace data {
+
+    /**
+     * This is a read-only columnar copy of a finished .var file
+     * (.vca file). The 128-byte header starts with the type string,
+     * as .var files do, followed by the version, the first time, the
+     * number of times, the payload byte length and the offsets of the
+     * two columns. The ready bitmap (bit i of byte i/8 tells whether
+     * first_time+i is ready) and the payload column (densely packed
+     * payloads, in time order) both start at a 64-byte aligned
+     * offset. The time index is implicit since stored times are
+     * contiguous.
+     */
+    class Archive {
+    private:
+
+      mutable std::ifstream file;
+      const symbol::Variable var_symb;
+      type::ref type;
+      std::size_t first_time;
+      std::size_t nb_times;
+      std::size_t byte_length;
+      std::size_t ready_pos;
+      std::size_t payload_pos;
+      std::vector<unsigned char> ready;
+      fs::path archive_path;
+      bool realized;
+
+      static std::size_t aligned(std::size_t pos) {
+	return ((pos + cxsom_ARCHIVE_ALIGNMENT - 1) / cxsom_ARCHIVE_ALIGNMENT) * cxsom_ARCHIVE_ALIGNMENT;
+      }
+
+      static void write_uint(std::ostream& os, std::size_t val) {
+	for(unsigned int i = 0; i < cxsom_UINT_LENGTH; ++i, val >>= 8) os.put((char)(val & 0xFF));
+      }
+
+      static std::size_t read_uint(std::istream& is) {
+	std::array<char, cxsom_UINT_LENGTH> buf;
+	is.read(std::data(buf), cxsom_UINT_LENGTH);
+	std::size_t nb = 0;
+	for(unsigned int i = cxsom_UINT_LENGTH; i > 0; --i) nb = (nb << 8) | (unsigned char)(buf[i-1]);
+	return nb;
+      }
+
+    public:
+
+      static fs::path path_of(const fs::path& archive_root, const symbol::Variable& var_symb) {
+	return archive_root / var_symb.timeline / (var_symb.name + ".vca");
+      }
+
+      /**
+       * This writes the archive of the variable var_symb, stored in
+       * root_path, into archive_root. It returns the number of
+       * archived ready instances.
+       */
+      static std::size_t build(const fs::path& root_path, const fs::path& archive_root, const symbol::Variable& var_symb) {
+	File src(root_path, var_symb);
+	src.realize(nullptr, std::nullopt, std::nullopt, true);
+	auto t = src.get_type();
+	auto [first, last] = src.get_time_range();
+	std::size_t nb = 0;
+	if(first != File::no_time() && src.get_file_size() != 0) nb = last - first + 1;
+	else first = File::no_time();
+
+	std::size_t length   = t->byte_length();
+	std::size_t r_pos    = cxsom_OFFSET_HEADER_IN_ARCHIVE;
+	std::size_t p_pos    = aligned(r_pos + (nb + 7) / 8);
+	std::size_t end_pos  = aligned(p_pos + nb * length);
+	std::vector<unsigned char> bitmap((nb + 7) / 8, 0);
+
+	auto p = path_of(archive_root, var_symb);
+	auto d = p;
+	d.remove_filename();
+	if(!fs::exists(d)) fs::create_directories(d);
+	std::ofstream os(p, std::ios::out | std::ios::binary | std::ios::trunc);
+	os.exceptions(std::ios::failbit | std::ios::badbit);
+
+	std::vector<char> header(cxsom_OFFSET_HEADER_IN_ARCHIVE, char(0));
+	os.write(std::data(header), header.size());
+	os.seekp(0, std::ios_base::beg);
+	os << t->name() << '\n';
+	os.seekp(cxsom_OFFSET_VERSION_IN_ARCHIVE, std::ios_base::beg);
+	write_uint(os, cxsom_ARCHIVE_VERSION);
+	write_uint(os, first);
+	write_uint(os, nb);
+	write_uint(os, length);
+	write_uint(os, r_pos);
+	write_uint(os, p_pos);
+
+	// Busy instances are written as zeros in the payload column.
+	auto value = data::make(t);
+	std::vector<char> zeros(length, char(0));
+	std::size_t nb_ready = 0;
+	os.seekp(p_pos, std::ios_base::beg);
+	for(std::size_t i = 0; i < nb; ++i)
+	  if(src.read(first + i, value) == FileAvailability::Ready) {
+	    bitmap[i / 8] |= (unsigned char)(1 << (i % 8));
+	    value->write(os);
+	    ++nb_ready;
+	  }
+	  else
+	    os.write(std::data(zeros), length);
+
+	if(auto pos = p_pos + nb * length; pos < end_pos) {
+	  std::vector<char> pad(end_pos - pos, char(0));
+	  os.write(std::data(pad), pad.size());
+	}
+	os.seekp(r_pos, std::ios_base::beg);
+	os.write(reinterpret_cast<const char*>(std::data(bitmap)), bitmap.size());
+	os << std::flush;
+	return nb_ready;
+      }
+
+      Archive() = delete;
+      Archive(const fs::path& archive_root,
+	      const symbol::Variable& var_symb)
+	: file(),
+	  var_symb(var_symb),
+	  archive_path(path_of(archive_root, var_symb)),
+	  realized(false) {
+	file.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+      }
+
+      bool exists() const {
+	return fs::exists(archive_path);
+      }
+
+      operator bool() const {return realized;}
+      operator symbol::Variable() const {return var_symb;}
+      type::ref get_type() const {return type;}
+
+      /**
+       * Returns (first, last), the time steps stored in the archive (last included). It may return (no_time, no_time) if the archive is empty.
+       */
+      std::pair<std::size_t, std::size_t> get_time_range() const {
+	if(nb_times == 0) return {File::no_time(), File::no_time()};
+	return {first_time, first_time + nb_times - 1};
+      }
+
+      /**
+       * This opens the archive, reads its header and loads the ready
+       * bitmap. The file is kept opened for further reads.
+       */
+      void realize() {
+	file.open(archive_path, std::ios::in | std::ios::binary);
+	std::string type_name;
+	file >> type_name;
+	type = type::make(type_name);
+	file.seekg(cxsom_OFFSET_VERSION_IN_ARCHIVE, std::ios_base::beg);
+	if(auto version = read_uint(file); version != cxsom_ARCHIVE_VERSION) {
+	  std::ostringstream ostr;
+	  ostr << "cxsom::data::Archive::realize : " << archive_path << " has version " << version << ", " << cxsom_ARCHIVE_VERSION << " expected.";
+	  throw error::file(ostr.str());
+	}
+	first_time  = read_uint(file);
+	nb_times    = read_uint(file);
+	byte_length = read_uint(file);
+	ready_pos   = read_uint(file);
+	payload_pos = read_uint(file);
+	ready.resize((nb_times + 7) / 8);
+	file.seekg(ready_pos, std::ios_base::beg);
+	file.read(reinterpret_cast<char*>(std::data(ready)), ready.size());
+	realized = true;
+      }
+
+      /**
+       * Same as File::read. Times after the archived range are Busy, times before are Forgotten.
+       */
+      FileAvailability read(std::size_t at, data::ref d) {
+	if(!realized) {
+	  std::ostringstream ostr;
+	  ostr << "Reading " << symbol::Instance(var_symb, at) << " while the archive for " << var_symb << " is not realized yet." << std::endl;
+	  throw error::file(ostr.str());
+	}
+	if(nb_times == 0 || at >= first_time + nb_times) return FileAvailability::Busy;
+	if(at < first_time)                              return FileAvailability::Forgotten;
+	std::size_t i = at - first_time;
+	if((ready[i / 8] & (1 << (i % 8))) == 0)        return FileAvailability::Busy;
+	file.seekg(payload_pos + i * byte_length, std::ios_base::beg);
+	d->read(file);
+	return FileAvailability::Ready;
+      }
+    };
+  }
+}
@@ -7,6 +7,36 @@
 #include <stdexcept>
 #include <vector>
 #include <array>
+#include <map>
+#include <mutex>
+#include <new>
+
+// The payload buffers of arrays and maps are aligned on this number
+// of bytes.
+#ifndef cxsom_PAYLOAD_ALIGNMENT
+#define cxsom_PAYLOAD_ALIGNMENT 64
+#endif
+
+// This is the maximal number of released payload buffers kept for
+// reuse, for each payload size.
+#ifndef cxsom_PAYLOAD_POOL_SIZE
+#define cxsom_PAYLOAD_POOL_SIZE 64
+#endif
+
+// This is the maximal total length (in bytes) of the released payload
+// buffers kept for reuse, all sizes together.
+#ifndef cxsom_PAYLOAD_POOL_BYTES
+#define cxsom_PAYLOAD_POOL_BYTES (std::size_t(64) << 20)
+#endif
+
+// Define cxsomHUGE_PAGES so that the payloads larger than a huge page
+// are aligned on huge pages and advised to be backed by them (Linux).
+#ifdef cxsomHUGE_PAGES
+#include <sys/mman.h>
+#ifndef cxsom_HUGE_PAGE_SIZE
+#define cxsom_HUGE_PAGE_SIZE 2097152
+#endif
+#endif
 
 namespace cxsom {
   namespace error {
@@ -176,6 +206,123 @@ namespace cxsom {
       b.print(os);
       return os;
     }
+
+    /**
+     * The payload buffers of arrays and maps are recycled by size, so
+     * that the many instances of the same geometry do not go back and
+     * forth to the system allocator.
+     */
+    class PayloadPool {
+    public:
+      
+      struct Occupancy {
+	std::size_t in_use = 0; //!< The buffers currently held by some data.
+	std::size_t free   = 0; //!< The released buffers kept for reuse.
+      };
+      
+    private:
+      
+      struct Slab {
+	std::vector<void*> free;
+	std::size_t in_use = 0;
+      };
+      
+      std::mutex mutex;
+      std::map<std::size_t, Slab> slabs; // The key is the buffer length in bytes.
+      std::size_t free_bytes = 0;         // The total length of the free buffers.
+
+      PayloadPool() = default;
+
+      static std::align_val_t alignment_of([[maybe_unused]] std::size_t bytes) {
+#ifdef cxsomHUGE_PAGES
+	if(bytes >= cxsom_HUGE_PAGE_SIZE) return std::align_val_t(cxsom_HUGE_PAGE_SIZE);
+#endif
+	return std::align_val_t(cxsom_PAYLOAD_ALIGNMENT);
+      }
+      
+    public:
+
+      /**
+       * The pool is never destroyed, so that data released at exit can still be given back.
+       */
+      static PayloadPool& get() {
+	static PayloadPool* pool = new PayloadPool();
+	return *pool;
+      }
+
+      void* allocate(std::size_t bytes) {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  auto& slab = slabs[bytes];
+	  ++slab.in_use;
+	  if(!slab.free.empty()) {
+	    auto res = slab.free.back();
+	    slab.free.pop_back();
+	    free_bytes -= bytes;
+	    return res;
+	  }
+	}
+	auto res = ::operator new(bytes, alignment_of(bytes));
+#ifdef cxsomHUGE_PAGES
+	if(bytes >= cxsom_HUGE_PAGE_SIZE) madvise(res, bytes, MADV_HUGEPAGE);
+#endif
+	return res;
+      }
+
+      void deallocate(void* buf, std::size_t bytes) {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  auto& slab = slabs[bytes];
+	  --slab.in_use;
+	  if(slab.free.size() < cxsom_PAYLOAD_POOL_SIZE && free_bytes + bytes <= cxsom_PAYLOAD_POOL_BYTES) {
+	    slab.free.push_back(buf);
+	    free_bytes += bytes;
+	    return;
+	  }
+	}
+	::operator delete(buf, alignment_of(bytes));
+      }
+
+      /**
+       * The free buffers are given back to the system.
+       */
+      void trim() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto it = slabs.begin(); it != slabs.end();) {
+	  for(auto buf : it->second.free) ::operator delete(buf, alignment_of(it->first));
+	  it->second.free.clear();
+	  if(it->second.in_use == 0) it = slabs.erase(it);
+	  else                       ++it;
+	}
+	free_bytes = 0;
+      }
+
+      /**
+       * @returns The occupancy of the pool, for each buffer length (in bytes).
+       */
+      std::map<std::size_t, Occupancy> occupancy() {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::map<std::size_t, Occupancy> res;
+	for(auto& [bytes, slab] : slabs) res[bytes] = {slab.in_use, slab.free.size()};
+	return res;
+      }
+    };
+
+    /**
+     * This allocator takes the buffers from the PayloadPool.
+     */
+    template<typename T>
+    struct payload_allocator {
+      using value_type = T;
+      payload_allocator() = default;
+      template<typename U> payload_allocator(const payload_allocator<U>&) {}
+      T*   allocate  (std::size_t n)         {return static_cast<T*>(PayloadPool::get().allocate(n * sizeof(T)));}
+      void deallocate(T* buf, std::size_t n) {PayloadPool::get().deallocate(buf, n * sizeof(T));}
+      template<typename U> bool operator==(const payload_allocator<U>&) const {return true;}
+      template<typename U> bool operator!=(const payload_allocator<U>&) const {return false;}
+    };
+
+    using payload = std::vector<double, payload_allocator<double>>;
   }
 
   
@@ -342,7 +489,7 @@ namespace cxsom {
     
     class Array : public Base {
     public:
-      std::vector<double> content;
+      payload content;
 	
       Array() = delete;
       Array(type::ref type) : Base(type), content(static_cast<const type::Array*>(type.get())->size, 0.) {}
@@ -571,7 +718,7 @@ namespace cxsom {
   namespace data {
     class Map : public Base {
     public:
-      std::vector<double> content;
+      payload content;
       unsigned int           side;
 	
       Map() = delete;
@@ -781,15 +928,32 @@ namespace cxsom {
 	throw cxsom::error::unknown_type(ostr.str());
       }
       
-      if(type->is_Scalar())     return ref(new Scalar(type));
-      if(type->is_Pos1D())      return ref(new d1::Pos(type));
-      if(type->is_Pos2D())      return ref(new d2::Pos(type));
-      if(type->is_Array() != 0) return ref(new Array(type));
-      if(type->is_Map())        return ref(new Map(type));
+      if(type->is_Scalar())     return std::make_shared<Scalar>(type);
+      if(type->is_Pos1D())      return std::make_shared<d1::Pos>(type);
+      if(type->is_Pos2D())      return std::make_shared<d2::Pos>(type);
+      if(type->is_Array() != 0) return std::make_shared<Array>(type);
+      if(type->is_Map())        return std::make_shared<Map>(type);
       
       std::ostringstream ostr;
       ostr << "cxsom::data::make : Cannot build any type from \"" << type->name() << "\".";
       throw cxsom::error::unknown_type(ostr.str());
     }
+
+    /**
+     * This is a copy of d. The payload of arrays and maps is taken
+     * from the PayloadPool and filled once, without being zeroed
+     * first as make would do.
+     */
+    inline ref copy(const Base& d) {
+      auto& type = d.type;
+      if(type->is_Scalar())     return std::make_shared<Scalar>(static_cast<const Scalar&>(d));
+      if(type->is_Pos1D())      return std::make_shared<d1::Pos>(static_cast<const d1::Pos&>(d));
+      if(type->is_Pos2D())      return std::make_shared<d2::Pos>(static_cast<const d2::Pos&>(d));
+      if(type->is_Array() != 0) return std::make_shared<Array>(static_cast<const Array&>(d));
+      if(type->is_Map())        return std::make_shared<Map>(static_cast<const Map&>(d));
+      auto res = make(type);
+      d.write(res->first_byte());
+      return res;
+    }
   }
 }
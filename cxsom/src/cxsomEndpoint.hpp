@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <optional>
+#include <iostream>
+#include <filesystem>
+
+#include <utility> // should be included by asio
+#include <asio.hpp>
+
+namespace cxsom {
+
+  /**
+   * Wherever a port is expected, "unix:/path" can be given instead,
+   * for a local (unix domain) stream socket. The protocols are the
+   * same, with a lower latency, and the access to the socket file is
+   * controlled by its permissions.
+   */
+  namespace endpoint {
+
+    /**
+     * @returns the socket file path if port is "unix:/path".
+     */
+    inline std::optional<std::string> local_path(const std::string& port) {
+      std::string prefix = "unix:";
+      if(port.compare(0, prefix.size(), prefix) == 0) return port.substr(prefix.size());
+      return std::nullopt;
+    }
+
+    /**
+     * This connects to hostname:port, or to the local socket if port
+     * is "unix:/path" (hostname is ignored then). The stream throws
+     * exceptions on failures.
+     */
+    inline std::unique_ptr<std::iostream> connect(const std::string& hostname, const std::string& port) {
+      if(auto path = local_path(port); path) {
+	auto socket = std::make_unique<asio::local::stream_protocol::iostream>();
+	socket->exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+	socket->connect(asio::local::stream_protocol::endpoint(*path));
+	return socket;
+      }
+      auto socket = std::make_unique<asio::ip::tcp::iostream>();
+      socket->exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+      socket->connect(hostname, port);
+      return socket;
+    }
+
+    /**
+     * This calls serve(acceptor) with an acceptor listening on port,
+     * or on the local socket if port is "unix:/path". A socket file
+     * left by a previous server is removed.
+     */
+    template<typename SERVE>
+    void listen(asio::io_service& ios, const std::string& port, const SERVE& serve) {
+      if(auto path = local_path(port); path) {
+	if(std::filesystem::is_socket(*path)) std::filesystem::remove(*path);
+	asio::local::stream_protocol::acceptor acceptor(ios, asio::local::stream_protocol::endpoint(*path));
+	serve(acceptor);
+      }
+      else {
+	asio::ip::tcp::acceptor acceptor(ios, asio::ip::tcp::endpoint(asio::ip::tcp::v4(), std::stoi(port)));
+	serve(acceptor);
+      }
+    }
+  }
+}
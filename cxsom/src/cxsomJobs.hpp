@@ -7,6 +7,8 @@
 #include <cxsomData.hpp>
 #include <cxsomOperation.hpp>
 #include <cxsomJobRule.hpp>
+#include <cxsomTrace.hpp>
+#include <cxsomStats.hpp>
 
 #include <map>
 #include <vector>
@@ -20,14 +22,29 @@
 #include <algorithm>
 #include <iomanip>
 #include <memory>
+#include <array>
 
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
 
 #include <skednet.hpp>
 
+// This is the maximal number of successive timesteps whose match
+// updates are computed in a single batch (see
+// jobs::Center::unprotected_batch). 0 disables batching.
+#ifndef cxsom_MATCH_BATCH_SIZE
+#define cxsom_MATCH_BATCH_SIZE 256
+#endif
+
+// This is the number of update objects kept for each pattern, in
+// order to be recycled for the next timesteps rather than rebuilt
+// (see jobs::Center::realize). 0 disables recycling.
+#ifndef cxsom_UPDATE_POOL_SIZE
+#define cxsom_UPDATE_POOL_SIZE 8
+#endif
 
 namespace cxsom {
 
@@ -48,20 +65,53 @@ namespace cxsom {
       TypeChecker type_checker;
       data::Center& data_center;
       mutable std::mutex integrity_mutex;
+      stats::Lock* integrity_stats;
 
       std::map<symbol::TimeStep, timestep::ref>   timesteps;
       std::deque<timestep::Task>                  tasks;
       std::map<symbol::Variable, pattern::Update> patterns;
+      std::map<std::string, timestep::Plan>       plans; // Per timeline, computed from the patterns when needed.
+
+      /**
+       * This is what the realization of a pattern needs, resolved
+       * once when the pattern is added: the variable handles and
+       * their types. The update objects made for the realizations are
+       * kept here as well, in order to be recycled.
+       */
+      struct Realization {
+	struct Side { // This is for one function, init or usual.
+	  std::vector<std::pair<data::Variable*, type::ref>> args;
+	  std::vector<update::ref>                           recycled;
+	  std::vector<update::bound_arg>                     bound; // for rebinding without allocation.
+	};
+	data::Variable* res      = nullptr;
+	type::ref       res_type = nullptr;
+	std::array<Side, 2> sides; // init, usual.
+      };
+      std::map<symbol::Variable, Realization>     realizations;
       
       std::vector<cxsom::symbol::TimeStep> terminated_ts;
       std::map<cxsom::symbol::TimeStep, std::set<cxsom::timestep::ref>> blockees;
 
-      std::atomic<bool>               interaction_ongoing;
+      std::atomic<unsigned int>       nb_interactions; // Several connections may interact at the same time.
       mutable std::mutex              job_mutex;
       mutable std::condition_variable pending_jobs;
       std::atomic<unsigned int>       nb_ongoing_processes;
 
       std::vector<type::ref> arg_types_tmp;
+
+      // The results computed by unprotected_batch are not held by any
+      // timestep. They are kept in the cache here until every pattern
+      // of their timeline is past them, since their variable may have
+      // no file to be read back from.
+      std::map<symbol::TimeStep, std::vector<data::instance_ref>> batched;
+
+      // The batches collected by unprotected_batch are computed by
+      // these jobs, without holding integrity_mutex. The patterns of
+      // a timeline are not realized while some of its batches (they
+      // are counted in batching) are not published.
+      std::deque<std::function<void ()>>   batch_jobs;
+      std::map<std::string, unsigned int> batching;
       
       void clean_timesteps() {
 	std::map<symbol::TimeStep, timestep::ref>::iterator it;
@@ -86,11 +136,22 @@ namespace cxsom {
 #endif
 	  }
 	}
+
+	// Unused recycled updates release their instances.
+	for(auto& [var, r] : realizations)
+	  for(auto& side : r.sides)
+	    for(auto& u : side.recycled)
+	      if(u.use_count() == 1 && u->is_bound()) u->unbind();
       }
       
       void integrity_notify_blocked(cxsom::timestep::ref me) {
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 	auto [begin, end] = me->new_blockers_range();
+	trace::instant(trace::Event::Blocked, [&me, begin = begin, end = end](auto& r) {
+	    symbol::TimeStep ts = *me;
+	    r.label(ts.timeline, "", ts.at);
+	    r.count = std::distance(begin, end);
+	  });
 	for(auto it = begin; it != end; ++it) blockees[*it].insert(me);
 	me->acq_new_blockers();
       }
@@ -98,15 +159,50 @@ namespace cxsom {
       void notify_done(const cxsom::symbol::TimeStep& me) {
 	terminated_ts.push_back(me);
 	if(auto it = blockees.find(me); it != blockees.end()) {
+	  trace::instant(trace::Event::Unblocked, [&me, it](auto& r) {
+	      r.label(me.timeline, "", me.at);
+	      r.count = it->second.size();
+	    });
 	  for(auto ts : it->second) ts->notify_unblock(me, [this](const auto& me){this->notify_done(me);});
 	}
       }
       
       void integrity_notify_done(const cxsom::symbol::TimeStep& me) {
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 	notify_done(me);
       }
 
+      // integrity_mutex is supposed to be held. The timesteps blocked
+      // by ts are re-tested, as if ts were done.
+      void unblock(const cxsom::symbol::TimeStep& ts) {
+	if(auto it = blockees.find(ts); it != blockees.end()) {
+	  auto blocked = std::move(it->second);
+	  blockees.erase(it);
+	  trace::instant(trace::Event::Unblocked, [&ts, &blocked](auto& r) {
+	      r.label(ts.timeline, "", ts.at);
+	      r.count = blocked.size();
+	    });
+	  for(auto& b : blocked) b->notify_unblock(ts, [this](const auto& me){this->notify_done(me);});
+	}
+      }
+
+      // This executes f while no task is executed, so that no task
+      // reads instances that f makes ready and then reports that they
+      // block it. Workers hold job_mutex while executing a task.
+      template<typename F>
+      void without_tasks(const F& f) {
+	interaction_lock();
+	try {
+	  std::unique_lock<std::mutex> lock(job_mutex);
+	  f();
+	}
+	catch(...) {
+	  interaction_release();
+	  throw;
+	}
+	interaction_release();
+      }
+
 
       timestep::ref check_and_get(const symbol::TimeStep& ts) {
 	if(auto it = timesteps.find(ts); it != timesteps.end())
@@ -116,6 +212,91 @@ namespace cxsom {
 	return res;
       }
 
+      const timestep::Plan& plan_of(const std::string& timeline) {
+	if(auto it = plans.find(timeline); it != plans.end()) return it->second;
+	timestep::Plan::graph g;
+	for(auto& [var, updt] : patterns)
+	  if(var.timeline == timeline) {
+	    auto& [has_init, args_in] = g[var.name];
+	    has_init = (bool)(updt.init);
+	    for(auto f : {&(updt.usual), updt.init ? &(*(updt.init)) : nullptr})
+	      if(f)
+		for(auto& arg : f->args)
+		  if(arg.variable.timeline == timeline
+		     && std::holds_alternative<symbol::pattern::relative>(arg.t)
+		     && std::get<symbol::pattern::relative>(arg.t).offset == 0)
+		    args_in.push_back(arg.variable.name);
+	  }
+	auto [it, inserted] = plans.try_emplace(timeline, g);
+#ifdef cxsomLOG
+	{
+	  std::ostringstream ostr;
+	  ostr << "Plan of timeline " << timeline << ':' << std::endl << it->second;
+	  logger->msg(ostr.str());
+	}
+#endif
+	return it->second;
+      }
+      
+      Realization resolve(const pattern::Update& updt) {
+	Realization r;
+	r.res      = &(data_center.handle(updt.res));
+	r.res_type = r.res->get_type();
+	for(auto [f, side] : {std::make_pair(updt.init ? &(*(updt.init)) : nullptr, &(r.sides[0])),
+			      std::make_pair(&(updt.usual), &(r.sides[1]))})
+	  if(f)
+	    for(auto& a : f->args) {
+	      auto& var = data_center.handle(a.variable);
+	      side->args.emplace_back(&var, var.get_type());
+	    }
+	return r;
+      }
+
+      /**
+       * An update of the side that is not used anymore is rebound to
+       * the instances at time at. Otherwise, a new update is made
+       * (and kept for recycling if there is room for it).
+       */
+      update::ref realize(const pattern::Function& f, Realization::Side& side,
+			  const update::bound_arg& res, const type::ref& res_type, unsigned int at) {
+	for(auto& u : side.recycled)
+	  if(u.use_count() == 1) { // Only the realization refers to it.
+	    side.bound.resize(f.args.size());
+	    auto bit = side.bound.begin();
+	    auto vit = side.args.begin();
+	    for(auto& a : f.args) {
+	      auto& [who, what] = *(bit++);
+	      who  = a.at(at);
+	      what = (*((vit++)->first))[who.at];
+	    }
+	    u->rebind(res, side.bound);
+	    return u;
+	  }
+
+	std::vector<update::arg> args;
+	auto vit = side.args.begin();
+	for(auto& a : f.args) args.emplace_back(a.at(at), (vit++)->second);
+	auto u = update_factory(data_center, f.op, {std::get<0>(res), res_type}, args, f.params, gen());
+	if(side.recycled.size() < cxsom_UPDATE_POOL_SIZE) side.recycled.push_back(u);
+	return u;
+      }
+
+      /**
+       * This adds the update of the pattern at time at in ts.
+       */
+      void add_update(const pattern::Update& updt, Realization& r, unsigned int at, timestep::ref ts) {
+	update::bound_arg res {symbol::Instance(updt.res, at), (*(r.res))[at]};
+	timestep::content c = updt.init
+	  ? timestep::content(realize(*(updt.init), r.sides[0], res, r.res_type, at),
+			      realize(updt.usual,   r.sides[1], res, r.res_type, at))
+	  : timestep::content(realize(updt.usual,   r.sides[1], res, r.res_type, at));
+	c.plan = plan_of(updt.res.timeline)(updt.res.name);
+#ifdef cxsomMONITOR
+	monitor->timestep_add_update(*ts, std::get<0>(res));
+#endif
+	*ts += c;
+      }
+      
       void add_update(const Update& updt, timestep::ref ts) {
 #ifdef cxsomLOG
 	logger->msg("Add update:");
@@ -161,6 +342,7 @@ namespace cxsom {
 #endif
 	for(auto& kv : patterns) {
 	  const auto& timeline = kv.first.timeline;
+	  if(batching.find(timeline) != batching.end()) continue;
 	  auto at = data_center.history_length(kv.second.res);
 #ifdef cxsomLOG
 	  std::ostringstream ostr1;
@@ -200,6 +382,15 @@ namespace cxsom {
 	  logger->pop();
 #endif
 
+	// Nothing reads the batched results anymore once the patterns
+	// of their timeline are past them.
+	for(auto it = batched.begin(); it != batched.end();)
+	  if(auto iter = min_update_time_in_timeline.find(it->first.timeline);
+	     iter == min_update_time_in_timeline.end() || iter->second > it->first.at)
+	    it = batched.erase(it);
+	  else
+	    ++it;
+
 	if(min_update_time_in_timeline.size() == 0) {
 #ifdef cxsomLOG
 	  logger->msg("No feasible update has been found from current patterns");
@@ -224,9 +415,15 @@ namespace cxsom {
 #ifdef cxsomLOG
 	logger->push();
 #endif
+	// The batches are collected first, so that no update reading
+	// their results is realized before they are published.
 	for(auto& kv : patterns)
 	  if(auto iter = min_update_time_in_timeline.find(kv.first.timeline);
 	     iter != min_update_time_in_timeline.end())
+	    unprotected_try_batch(kv.second, iter->second);
+	for(auto& kv : patterns)
+	  if(auto iter = min_update_time_in_timeline.find(kv.first.timeline);
+	     iter != min_update_time_in_timeline.end() && batching.find(kv.first.timeline) == batching.end())
 	    unprotected_realize(kv.second, iter->second);
 #ifdef cxsomLOG
 	logger->pop();
@@ -237,6 +434,104 @@ namespace cxsom {
 #endif
       }
       
+      // Appends the content of who to out if who is ready.
+      bool unprotected_read_ready(const symbol::Instance& who, std::vector<double>& out) {
+	auto inst   = data_center[who];
+	auto status = data::Availability(*inst);
+	if(status == data::Availability::Busy) inst->sync([&status](auto s) {status = s;});
+	if(status != data::Availability::Ready) return false;
+	inst->get([&out](auto, auto, auto& data) {
+	    auto [begin, end] = data.data_range();
+	    out.insert(out.end(), begin, end);
+	  });
+	return true;
+      }
+
+      /**
+       * In frozen timelines, the match updates of successive
+       * timesteps read the same weight instance, which is ready, and
+       * inputs from other timelines, which may be ready already. In
+       * this case, the results for at, at+1, ... are computed in a
+       * single batch, and set ready without building any update. They
+       * are held in batched until they are read, since the result
+       * variable may have no file (e.g. in frozen timelines recorded
+       * partially). The batch is only collected here, it is computed
+       * by a job of batch_jobs and published when it is done. This
+       * returns the number of results of the batch, 0 if the pattern
+       * cannot be batched.
+       */
+      std::size_t unprotected_batch(const pattern::Update& updt, std::size_t at) {
+	if(updt.init || updt.usual.args.size() != 2) return 0;
+	const auto& input_arg  = updt.usual.args[0];
+	const auto& weight_arg = updt.usual.args[1];
+	if(!std::holds_alternative<symbol::pattern::absolute>(weight_arg.t)) return 0;
+	// Both arguments have to be out-args for all the batched timesteps.
+	if(input_arg.variable.timeline == updt.res.timeline || weight_arg.variable.timeline == updt.res.timeline) return 0;
+
+	std::size_t nb_max = cxsom_MATCH_BATCH_SIZE;
+	if(updt.walltime != std::numeric_limits<unsigned int>::max()) nb_max = std::min(nb_max, updt.walltime + 1 - at);
+	if(nb_max < 2) return 0;
+
+	auto batch = update_factory.batch(updt.usual.op, updt.usual.params);
+	if(!batch) return 0;
+	
+	std::vector<double> batch_weights;
+	if(!unprotected_read_ready(weight_arg.at(at), batch_weights)) return 0;
+
+	std::vector<double> batch_inputs;
+	std::size_t nb = 0;
+	for(; nb < nb_max; ++nb) {
+	  auto res = symbol::Instance(updt.res, at + nb);
+	  if(auto it = timesteps.find(res); it != timesteps.end() && it->second->has_instance(res)) break;
+	  if(data::Availability(*(data_center[res])) != data::Availability::Busy) break;
+	  if(!unprotected_read_ready(input_arg.at(at + nb), batch_inputs)) break;
+	}
+	if(nb < 2) return 0;
+
+	std::size_t nb_units = data_center.type_of(updt.res)->byte_length() / sizeof(double);
+	++batching[updt.res.timeline];
+	batch_jobs.push_back([this, batch, res = updt.res, op = updt.usual.op, at, nb, nb_units,
+			      weights = std::move(batch_weights), inputs = std::move(batch_inputs)]() {
+	    auto start = std::chrono::steady_clock::now();
+	    std::size_t dim = inputs.size() / nb;
+	    std::vector<double> results(nb * nb_units);
+	    (*batch)(std::data(weights), nb_units, dim, std::data(inputs), nb, std::data(results));
+	    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	    {
+	      stats::Guard lock(integrity_mutex, *integrity_stats);
+	      auto row = results.begin();
+	      for(std::size_t k = 0; k < nb; ++k, row += nb_units) {
+		auto inst = data_center[symbol::Instance(res, at + k)];
+		inst->set([row, nb_units](auto& status, auto& datation, auto& data) {
+		    auto [begin, end] = data.data_range();
+		    std::copy(row, row + nb_units, begin);
+		    datation = 1;
+		    status   = data::Availability::Ready;
+		  });
+		batched[symbol::TimeStep(res.timeline, at + k)].push_back(inst);
+		unblock(symbol::TimeStep(res.timeline, at + k));
+	      }
+	      if(auto it = batching.find(res.timeline); --(it->second) == 0) batching.erase(it);
+	    }
+	    stats::Registry::get().operation(op + "/batch").task_done(duration);
+	    pending_jobs.notify_all();
+	  });
+	return nb;
+      }
+      
+      void unprotected_try_batch(const pattern::Update& updt, std::size_t min_at) {
+	try {
+	  auto at = data_center.history_length(updt.res);
+	  if(at > updt.walltime || at != min_at) return;
+	  if(auto nb = unprotected_batch(updt, at); nb > 0) {
+#ifdef cxsomLOG
+	    logger->msg(std::string("batch computation of ") + std::to_string(nb) + " timesteps of " + updt.res.timeline + " from " + std::to_string(at) + " queued.");
+#endif
+	  }
+	}
+	catch(const error::negative_time&) {}
+      }
+      
       void unprotected_realize(const pattern::Update& updt, std::size_t min_at) {
 #ifdef cxsomLOG
 	std::size_t indent = logger->indentation;
@@ -283,12 +578,12 @@ namespace cxsom {
 	      ostr << "inserting update from pattern: " << std::endl
 		   << u;
 	      logger->msg(ostr.str());
-	      add_update(u, ts);
+	      add_update(updt, realizations.at(updt.res), at, ts);
 	      logger->pop();
 	    }
 	    logger->pop();
 #else
-	    if(!(ts->has_instance(res))) add_update(pattern::at(updt, at), ts);
+	    if(!(ts->has_instance(res))) add_update(updt, realizations.at(updt.res), at, ts);
 #endif
 	  }
 	}
@@ -336,12 +631,15 @@ namespace cxsom {
 	  type_checker(type_checker),
 	  data_center(data_center),
 	  integrity_mutex(),
+	  integrity_stats(&(stats::Registry::get().lock("integrity"))),
 	  timesteps(),
 	  tasks(),
 	  patterns(),
+	  plans(),
+	  realizations(),
 	  terminated_ts(),
 	  blockees(),
-	  interaction_ongoing(false),
+	  nb_interactions(0),
 	  job_mutex(),
 	  pending_jobs(),
 	  nb_ongoing_processes(0),
@@ -355,8 +653,10 @@ namespace cxsom {
       Center& operator=(Center&&)      = default;
       
       void operator+=(const pattern::Update& updt) {
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 	type_checking(updt);
+	plans.erase(updt.res.timeline);
+	realizations.insert_or_assign(updt.res, resolve(updt));
 	if(auto it = patterns.find(updt.res); it == patterns.end())
 	  patterns.try_emplace(updt.res, updt);
 	else
@@ -372,7 +672,7 @@ namespace cxsom {
       }
       
       void operator+=(const Update& updt) {
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 	if(data::Availability(*(data_center[updt.res])) == data::Availability::Ready)
 	  return;
 	type_checking(updt);
@@ -380,7 +680,7 @@ namespace cxsom {
       }
 
       void clear() {
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 #ifdef cxsomLOG
 	logger->msg("clearing everything !.");
 #endif
@@ -391,9 +691,14 @@ namespace cxsom {
 	timesteps.clear();
 	tasks.clear();
 	patterns.clear();
+	plans.clear();
+	realizations.clear();
 	terminated_ts.clear();
 	blockees.clear();
 	arg_types_tmp.clear();
+	batched.clear();
+	batch_jobs.clear();
+	batching.clear();
       }
 
       /**
@@ -401,7 +706,7 @@ namespace cxsom {
        * impossible update become unstable, in order to be re-tested.
        */
       void clear_blocking_info() {
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 #ifdef cxsomLOG
 	logger->msg("");
 	logger->msg("clear_blocking_info()... for all timesteps.");
@@ -415,6 +720,39 @@ namespace cxsom {
 #endif
       }
 
+      /**
+       * This calls write(), which sets instances of the timesteps
+       * [first_at, first_at + count) of the timeline from outside (for
+       * feed). Then, only the timesteps blocked by these ones are
+       * re-tested, instead of all of them as with
+       * clear_blocking_info. They get blocked again if some instances
+       * they wait for are still missing.
+       */
+      template<typename WRITE>
+      void feed(const std::string& timeline, std::size_t first_at, std::size_t count, const WRITE& write) {
+	without_tasks([this, &timeline, first_at, count, &write]() {
+	    write();
+	    stats::Guard lock(integrity_mutex, *integrity_stats);
+	    for(std::size_t at = first_at; at < first_at + count; ++at) unblock(symbol::TimeStep(timeline, at));
+	  });
+      }
+
+      /**
+       * This is called when the instances of var in [from_at, to_at]
+       * may have been written in its file by someone else (for
+       * notify). Only the cached instances of var known as busy are
+       * read again, and only the timesteps blocked by the ones which
+       * are ready now are re-tested. clear_blocking_info reads again
+       * the busy arguments of every pending update instead.
+       */
+      void notify_written(const symbol::Variable& var, std::size_t from_at, std::size_t to_at) {
+	without_tasks([this, &var, from_at, to_at]() {
+	    auto ready = data_center.sync_busy(var, from_at, to_at);
+	    stats::Guard lock(integrity_mutex, *integrity_stats);
+	    for(auto at : ready) unblock(symbol::TimeStep(var.timeline, at));
+	  });
+      }
+
       /**
        * We call this in mono-thread mode (locking integrity_mutex) in order to get the next job to do.
        */
@@ -428,7 +766,7 @@ namespace cxsom {
 	logger->msg("get_one()...");
 	logger->push();
 #endif
-	std::lock_guard<std::mutex> lock(integrity_mutex);
+	stats::Guard lock(integrity_mutex, *integrity_stats);
 #ifdef cxsomLOG
 	logger->msg("... mutex passed.");
 #endif
@@ -533,6 +871,21 @@ namespace cxsom {
 #endif
 	}
 	
+	if(tasks.empty() && !batch_jobs.empty()) {
+	  ++nb_ongoing_processes;
+	  if(!flushing_tasks_in_progress && nb_ongoing_processes == 1) {
+	    flushing_tasks_in_progress = true;
+	    on_start_flushing_tasks();
+	  }
+	  auto job = std::move(batch_jobs.front());
+	  batch_jobs.pop_front();
+#ifdef cxsomLOG
+	  logger->msg("Returning a batch computation.");
+	  logger->pop();
+#endif
+	  return job;
+	}
+	
 	if(tasks.empty())  {
 #ifdef cxsomMONITOR
 	  monitor->job_out_of_task(Monitor::OutOfTasksReason::NoneFromPatterns);
@@ -585,8 +938,27 @@ namespace cxsom {
 	logger->pop();
 #endif
 	return [this, task]() mutable {
-		 task([this](auto        me) {this->integrity_notify_blocked(me);},
-		      [this](const auto& me) {this->integrity_notify_done(me);   });
+		 {
+		   auto updt = task.update();
+		   if(!updt->operation_stats) updt->operation_stats = &(stats::Registry::get().operation(updt->function_name()));
+		   trace::Span span(trace::Event::Task);
+		   auto start = std::chrono::steady_clock::now();
+		   task([this](auto        me) {this->integrity_notify_blocked(me);},
+			[this](const auto& me) {this->integrity_notify_done(me);   });
+		   updt->operation_stats->task_done(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		   if(span) {
+		     auto& who = task.update.usual->result.who;
+		     span->label(who.variable.timeline, who.variable.name, who.at);
+		     span->info[0] = static_cast<char>(task.report);
+		   }
+		 }
+		 if(task.report == update::Status::Done && task.update.plan && task.update.plan->planned) {
+		   // The next updates of the plan are run first.
+		   stats::Guard lock(integrity_mutex, *integrity_stats);
+		   std::vector<timestep::Task> next;
+		   task.step->get_jobs(task.step, std::back_inserter(next));
+		   tasks.insert(tasks.begin(), next.begin(), next.end());
+		 }
 #ifdef cxsomLOG
 		 logger->msg("status after task execution:");
 		 std::ostringstream ostr;
@@ -601,23 +973,40 @@ namespace cxsom {
        * This function is a worker thread.
        */
       void worker_thread() {
+	auto& me = stats::Registry::get().worker();
+	auto since = [](auto start) {return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();};
 	std::unique_lock<std::mutex> lock(job_mutex);
 	while(true) {
-	  if(interaction_ongoing) pending_jobs.wait(lock);
+	  auto start = std::chrono::steady_clock::now();
+	  if(nb_interactions > 0) {
+	    pending_jobs.wait(lock);
+	    stats::add(me.idle, since(start));
+	  }
 	  else {
-	    if(auto job = get_one(); job) {
+	    auto job = get_one();
+	    stats::add(me.scheduling, since(start));
+	    if(job) {
+	      start = std::chrono::steady_clock::now();
 	      job();
+	      stats::add(me.busy, since(start));
+	      stats::add(me.nb_tasks, 1);
 	      --nb_ongoing_processes;
 	    }
-	    else pending_jobs.wait(lock);
+	    else {
+	      start = std::chrono::steady_clock::now();
+	      pending_jobs.wait(lock);
+	      stats::add(me.idle, since(start));
+	    }
 	  }
 	}
       }
 
       /**
-       * This interrupts the runing of new updates so that interaction can be done.
+       * This interrupts the runing of new updates so that interaction
+       * can be done. Updates run again when every interaction_lock has
+       * been released.
        */
-      void interaction_lock()    {interaction_ongoing = true;}
+      void interaction_lock()    {++nb_interactions;}
 
       /**
        * This ends interaction sequence, and notifies worker that some
@@ -625,7 +1014,9 @@ namespace cxsom {
        * interaction_lock, just for starting the computation.
        */
       void interaction_release() {
-	interaction_ongoing = false;
+	// An unpaired release leaves the count at 0.
+	unsigned int nb = nb_interactions;
+	while(nb > 0 && !nb_interactions.compare_exchange_weak(nb, nb - 1)) {}
 	{
 	  std::unique_lock<std::mutex> lock(job_mutex);
 	  pending_jobs.notify_all();
@@ -145,6 +145,7 @@ namespace cxsom {
       
       void tick() {++ctr;};
       bool expired() {return ctr >= deadline;}
+      void restart() {ctr = 0;}
 
       Deadline(const std::map<std::string, std::string>& params)
 	: ctr(0), deadline(100) {
@@ -337,6 +338,10 @@ namespace cxsom {
       }
       
     protected:
+
+      virtual void on_rebind() override {
+	sum_out_computed = false;
+      }
       
       virtual void on_computation_start() override {
 	if(!sum_out_computed) {
@@ -523,6 +528,13 @@ namespace cxsom {
       
     protected:
 
+      virtual void on_rebind() override {
+	nb_converges = 0;
+#ifdef cxsomDEBUG_CONVERGE
+	argval.clear();
+#endif
+      }
+
       
 #ifdef cxsomDEBUG_CONVERGE
       virtual void on_read_in_arg(const symbol::Instance&, unsigned int arg_num, const data::Base& data) override {
@@ -841,13 +853,124 @@ namespace cxsom {
 	}
 	else
 	  throw std::runtime_error("MatchGaussian : input type is bad, while it has been checked");
-	
-	  
+
+
 	return max_diff > epsilon;
       }
-      
+
+    };
+
+    ////////////////
+    //            //
+    // MatchBatch //
+    //            //
+    ////////////////
+
+    // This is the size (in bytes) of the block of weights that is
+    // matched against all the inputs of a batch before the next block
+    // is considered. It should fit in the L1 cache.
+#ifndef cxsom_MATCH_BATCH_BLOCK_SIZE
+#define cxsom_MATCH_BATCH_BLOCK_SIZE 16384
+#endif
+
+    /**
+     * This computes the result of an operation for several inputs
+     * sharing the same weights, in a single pass.
+     */
+    class Batch {
+    public:
+      virtual ~Batch() {}
+
+      /**
+       * @param weights   nb_units x dim values (the content of the weight map).
+       * @param inputs    nb_inputs x dim values.
+       * @param results   nb_inputs x nb_units values, row i is the result for input i.
+       */
+      virtual void operator()(const double* weights, std::size_t nb_units, std::size_t dim,
+			      const double* inputs, std::size_t nb_inputs,
+			      double* results) const = 0;
+    };
+
+    using batch_ref = std::shared_ptr<Batch>;
+
+    /**
+     * The match of each input against all the units, the units being
+     * visited per cache-sized blocks. Within a block, each unit is
+     * compared to 4 inputs at once, so that its weights are loaded
+     * once for them and the 4 squared distances are accumulated
+     * independently. Each distance is summed in the same order as
+     * match::gaussian and match::triangle do, so the results are
+     * identical to the ones of the match updates. The transfer turns
+     * a squared distance into the match value.
+     */
+    template<typename TRANSFER>
+    class MatchBatch : public Batch {
+    private:
+      TRANSFER transfer;
+
+    public:
+      MatchBatch(const TRANSFER& transfer) : transfer(transfer) {}
+
+      virtual void operator()(const double* weights, std::size_t nb_units, std::size_t dim,
+			      const double* inputs, std::size_t nb_inputs,
+			      double* results) const override {
+	std::size_t block = std::max(std::size_t(1), std::size_t(cxsom_MATCH_BATCH_BLOCK_SIZE) / (dim * sizeof(double)));
+	for(std::size_t u_begin = 0; u_begin < nb_units; u_begin += block) {
+	  std::size_t u_end = std::min(nb_units, u_begin + block);
+	  std::size_t i = 0;
+	  for(; i + 4 <= nb_inputs; i += 4) {
+	    const double* x0 = inputs + i * dim;
+	    const double* x1 = x0 + dim;
+	    const double* x2 = x1 + dim;
+	    const double* x3 = x2 + dim;
+	    double* row = results + i * nb_units;
+	    const double* w = weights + u_begin * dim;
+	    for(std::size_t u = u_begin; u < u_end; ++u, w += dim) {
+	      double d0 = 0, d1 = 0, d2 = 0, d3 = 0;
+	      for(std::size_t k = 0; k < dim; ++k) {
+		double wk = w[k], t0 = wk - x0[k], t1 = wk - x1[k], t2 = wk - x2[k], t3 = wk - x3[k];
+		d0 += t0*t0; d1 += t1*t1; d2 += t2*t2; d3 += t3*t3;
+	      }
+	      row[u]                = transfer(d0);
+	      row[u +     nb_units] = transfer(d1);
+	      row[u + 2 * nb_units] = transfer(d2);
+	      row[u + 3 * nb_units] = transfer(d3);
+	    }
+	  }
+	  for(; i < nb_inputs; ++i) {
+	    const double* x   = inputs + i * dim;
+	    double*       row = results + i * nb_units;
+	    const double* w   = weights + u_begin * dim;
+	    for(std::size_t u = u_begin; u < u_end; ++u, w += dim) {
+	      double d = 0;
+	      for(std::size_t k = 0; k < dim; ++k) {
+		double t = w[k] - x[k];
+		d += t*t;
+	      }
+	      row[u] = transfer(d);
+	    }
+	  }
+	}
+      }
     };
 
+    inline batch_ref make_batch_match_triangle(const std::map<std::string, std::string>& params) {
+      double _r = 2;
+      if(auto it = params.find("r"); it != params.end()) _r = 1/std::stod(it->second);
+      auto f = [_r](double d2) {return std::max(0., 1.-_r*std::sqrt(d2));};
+      return std::make_shared<MatchBatch<decltype(f)>>(f);
+    }
+
+    inline batch_ref make_batch_match_gaussian(const std::map<std::string, std::string>& params) {
+      double _2sigma2 = .5;
+      if(auto it = params.find("sigma"); it != params.end()) {
+	double tmp = std::stod(it->second);
+	_2sigma2  = .5/(tmp * tmp);
+      }
+      auto f = [_2sigma2](double d2) {return std::exp(-_2sigma2*d2);};
+      return std::make_shared<MatchBatch<decltype(f)>>(f);
+    }
+
 
 
     ///////////
@@ -1237,6 +1360,10 @@ namespace cxsom {
 	if(auto it = params.find("random-bmu"); it != params.end()) random_bmu = (std::stod(it->second) != 0);
       }
 
+      virtual void on_rebind() override {
+	restart();
+      }
+
       std::size_t find_argmax(const double* begin, std::size_t size) const {
 	if(random_bmu) {
 	  std::vector<std::size_t> bmus;
@@ -1993,8 +2120,10 @@ namespace cxsom {
 							  const std::vector<update::arg>&,
 							  const std::map<std::string, std::string>&,
 							  std::mt19937::result_type seed)>;
+      using make_batch_type  = std::function<batch_ref (const std::map<std::string, std::string>&)>;
     private:
       std::map<Operation, make_update_type> factory;
+      std::map<Operation, make_batch_type>  batch_factory;
       
     public:
 
@@ -2016,6 +2145,25 @@ namespace cxsom {
 	else
 	  throw error::not_existing_update(op);
       }
+
+      /**
+       * This registers a batched version of the operation op (see Batch).
+       */
+      void add_batch(Operation op, const make_batch_type& make_batch) {
+	if(auto it = batch_factory.find(op); it == batch_factory.end())
+	  batch_factory[op] = make_batch;
+	else
+	  throw error::already_existing_update(op);
+      }
+
+      /**
+       * @returns nullptr if op has no batched version.
+       */
+      batch_ref batch(Operation op, const std::map<std::string, std::string>& params) const {
+	if(auto it = batch_factory.find(op); it != batch_factory.end())
+	  return it->second(params);
+	return nullptr;
+      }
     };
 
     void fill(UpdateFactory& factory) {
@@ -2040,6 +2188,9 @@ namespace cxsom {
       factory += {"first"             , make_update_deterministic<First>        };
       factory += {"second"            , make_update_deterministic<Second>       };
       factory += {"value-at"          , make_update_deterministic<ValueAt>      };
+
+      factory.add_batch("match-triangle", make_batch_match_triangle);
+      factory.add_batch("match-gaussian", make_batch_match_gaussian);
     }
 
 
@@ -16,14 +16,16 @@ namespace cxsom {
       inline void variable  (std::ostream& os, const rules::value_key& v) {os << v.timeline << ' ' << v.name << ' ';}
       inline void type_value(std::ostream& os, const std::string& t     ) {os << t << ' ';}
       inline void storage   (std::ostream& os, std::size_t cache_size,
-			     std::size_t file_size, bool kept_opened)    {os << cache_size << ' ' << file_size << ' ' << kept_opened << ' ';}
+			     std::size_t file_size, bool kept_opened,
+			     bool in_memory = false)                     {os << cache_size << ' ' << file_size << ' ' << (in_memory ? 2 : int(kept_opened)) << ' ';}
 
       inline void type_declaration(std::ostream& os,
 				   const rules::value_key& v,
 				   const std::string& t,
 				   std::size_t cache_size,
 				   std::size_t file_size,
-				   bool kept_opened) {
+				   bool kept_opened,
+				   bool in_memory = false) {
 #ifdef cxsomDEBUG_PROTOCOL
 	std::ostringstream ss;
 	std::ostream& ostr = ss;
@@ -31,7 +33,7 @@ namespace cxsom {
 	std::ostream& ostr = os;
 #endif
 	
-	ostr << "declare "; variable(ostr, v); type_value(ostr, t); storage(ostr, cache_size, file_size, kept_opened); ostr << std::endl;
+	ostr << "declare "; variable(ostr, v); type_value(ostr, t); storage(ostr, cache_size, file_size, kept_opened, in_memory); ostr << std::endl;
 	
 #ifdef cxsomDEBUG_PROTOCOL
 	std::cout << "<< " << ss.str(); os << ss.str();
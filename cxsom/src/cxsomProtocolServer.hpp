@@ -38,14 +38,17 @@ namespace cxsom {
 	return type::make(buf);
       }
 
-      inline std::tuple<std::size_t, std::size_t, bool> storage(std::istream& is) {
-	std::size_t cache_size;
-	std::size_t file_size;
-	bool        kept_opened;
-	char        c;
-	is >> cache_size >> file_size >> kept_opened;
+      /**
+       * @returns (cache_size, file_size, kept_opened, in_memory). The last storage token is 0 (file opened as needed), 1 (file kept opened) or 2 (in memory, no file).
+       */
+      inline std::tuple<std::size_t, std::size_t, bool, bool> storage(std::istream& is) {
+	std::size_t  cache_size;
+	std::size_t  file_size;
+	unsigned int mode;
+	char         c;
+	is >> cache_size >> file_size >> mode;
 	is.get(c);
-	return {cache_size, file_size, kept_opened};
+	return {cache_size, file_size, mode == 1, mode == 2};
       }
 
 
@@ -57,8 +60,8 @@ namespace cxsom {
 #endif
 	auto v = variable(is);
 	auto t = type_value(is);
-	auto [cache_size, file_size, kept_opened] = storage(is);
-	fct(v, t, cache_size, file_size, kept_opened);
+	auto [cache_size, file_size, kept_opened, in_memory] = storage(is);
+	fct(v, t, cache_size, file_size, kept_opened, in_memory);
 #ifdef cxsomDEBUG_PROTOCOL
 	std::cout << "-- type_declaration <<<<" << std::endl;
 #endif
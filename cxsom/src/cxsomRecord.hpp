@@ -0,0 +1,156 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+namespace cxsom {
+  namespace record {
+
+    /**
+     * Recording is switched on and off at runtime. When it is off,
+     * the received lines are only forwarded.
+     */
+    inline std::atomic<bool> active {false};
+
+    /**
+     * These are the commands that are recorded, i.e. the ones that
+     * a replay sends again. Static and pattern lines follow an
+     * updates line.
+     */
+    inline bool is_recorded(const std::string& command) {
+      return command == "declare" || command == "updates" || command == "static" || command == "pattern"
+	|| command == "ping" || command == "clear";
+    }
+
+    /**
+     * The capture file starts with a comment line. Then, each line
+     * is a received command line, prefixed by its time (µs since the
+     * recording has started) and the connection it comes from. The
+     * command lines are kept verbatim, trailing spaces included,
+     * since the parsers expect them.
+     */
+    class Recorder {
+    private:
+
+      std::mutex mutex;
+      std::ofstream file;
+      std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+      std::atomic<unsigned int> nb_connections {0};
+
+      Recorder() = default;
+
+    public:
+
+      /**
+       * The recorder lives as long as the process, since service
+       * threads are detached.
+       */
+      static Recorder& get() {
+	static Recorder* recorder = new Recorder();
+	return *recorder;
+      }
+
+      /**
+       * @returns false if the capture file cannot be written.
+       */
+      bool start(const std::string& path) {
+	std::lock_guard<std::mutex> lock(mutex);
+	active = false;
+	if(file.is_open()) file.close();
+	file.open(path);
+	if(!file) return false;
+	file << "# cxsom capture : <time (µs)> <connection> <command line>" << std::endl;
+	origin = std::chrono::steady_clock::now();
+	active = true;
+	return true;
+      }
+
+      void stop() {
+	std::lock_guard<std::mutex> lock(mutex);
+	active = false;
+	if(file.is_open()) file.close();
+      }
+
+      unsigned int connection() {return nb_connections++;}
+
+      void write(unsigned int connection, const std::string& line) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(!file.is_open()) return;
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+	file << us << ' ' << connection << ' ' << line << std::endl;
+      }
+    };
+
+    /**
+     * This stream buffer is set in front of the one of a connection
+     * socket, between two commands, while recording is active. It
+     * forwards everything and records the received lines. It has no
+     * buffer of its own, the socket one is used, so it can be
+     * removed at any command boundary.
+     */
+    class Tee : public std::streambuf {
+    private:
+
+      std::streambuf* src;
+      unsigned int id;
+      std::string line;
+      bool at_line_start = true;
+      bool recording     = false; // The current line is recorded.
+
+      void consumed(int_type c) {
+	if(traits_type::eq_int_type(c, traits_type::eof())) return;
+	char ch = traits_type::to_char_type(c);
+	if(at_line_start) {
+	  recording     = active.load(std::memory_order_relaxed);
+	  at_line_start = false;
+	}
+	if(ch != '\n') {
+	  if(recording) line.push_back(ch);
+	  return;
+	}
+	at_line_start = true;
+	if(!recording) return;
+	if(is_recorded(line.substr(0, line.find(' ')))) Recorder::get().write(id, line);
+	line.clear();
+      }
+
+    public:
+
+      Tee(std::streambuf* src) : src(src), id(Recorder::get().connection()) {}
+
+    protected:
+
+      virtual int_type underflow() override {return src->sgetc();}
+
+      virtual int_type uflow() override {
+	auto c = src->sbumpc();
+	consumed(c);
+	return c;
+      }
+
+      // The protocol parsers put back the characters they have just
+      // read, which are still in the socket buffer.
+      virtual int_type pbackfail(int_type c) override {
+	auto res = traits_type::eq_int_type(c, traits_type::eof()) ? src->sungetc() : src->sputbackc(traits_type::to_char_type(c));
+	if(!traits_type::eq_int_type(res, traits_type::eof()) && recording && !line.empty()) line.pop_back();
+	return res;
+      }
+
+      virtual std::streamsize showmanyc() override {return src->in_avail();}
+
+      virtual int_type overflow(int_type c) override {
+	if(traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+	return src->sputc(traits_type::to_char_type(c));
+      }
+
+      virtual std::streamsize xsputn(const char* s, std::streamsize n) override {return src->sputn(s, n);}
+
+      virtual int sync() override {return src->pubsync();}
+    };
+  }
+}
@@ -23,6 +23,8 @@
 #include <utility> // should be included by asio
 #include <asio.hpp>
 
+#include <cxsomEndpoint.hpp>
+
 namespace cxsom {
   namespace rules {
 
@@ -56,18 +58,20 @@ namespace cxsom {
     struct value;
     using value_ref = std::shared_ptr<value>;
 
-    using type_info = std::tuple<std::string, std::size_t, std::size_t, bool>;
+    using type_info = std::tuple<std::string, std::size_t, std::size_t, bool, bool>;
     
     std::string type_of       (const type_info& info) {return std::get<0>(info);}
     std::size_t cache_size_of (const type_info& info) {return std::get<1>(info);}
     std::size_t file_size_of  (const type_info& info) {return std::get<2>(info);}
     bool        kept_opened_of(const type_info& info) {return std::get<3>(info);}
+    bool        in_memory_of  (const type_info& info) {return std::get<4>(info);}
 
     inline std::ostream& operator<<(std::ostream& os, const type_info& info) {
       os << "{type = "                           << type_of       (info)
 	 << ", cache_size = "                    << cache_size_of (info)
 	 << ", file_size = "                     << file_size_of  (info)
 	 << ", kept_opened = " << std::boolalpha << kept_opened_of(info)
+	 << ", in_memory = "   << std::boolalpha << in_memory_of  (info)
 	 << '}';
       return os;
     }
@@ -224,6 +228,18 @@ namespace cxsom {
       void type(const std::vector<data> range,
 		const std::string& t,
 		bool kept_opened);
+
+      /**
+       * The variable is only kept in the memory of the processor, it
+       * has no file. This fits internal variables whose history is
+       * not recorded (file_size = 0).
+       */
+      void in_memory_type(data d,
+			  const std::string& t,
+			  std::size_t cache_size);
+      void in_memory_type(const std::vector<data> range,
+			  const std::string& t,
+			  std::size_t cache_size);
       std::string type_of(data d);
 
       std::string var_path(const std::string& root_dir, data d) {
@@ -351,7 +367,8 @@ namespace cxsom {
 			const std::string& t,
 			std::size_t cache_size,
 			std::size_t file_size,
-			bool kept_opened);
+			bool kept_opened,
+			bool in_memory = false);
       std::string type_of(value_key v) const;
       update& add_update(value_at_key v, update& u);
       update& add_init(value_at_key v, update& u);
@@ -359,8 +376,8 @@ namespace cxsom {
 
       void check_walltimes() const;
       void check_orphan_inits() const;
-      void handle_answer(asio::ip::tcp::iostream& socket);
-      void send(const std::string& hostname, int port);
+      void handle_answer(std::iostream& socket);
+      void send(const std::string& hostname, const std::string& port);
       void print_graph(std::ostream& file, std::map<value_at_key, update>& rules, bool full_names);
       void notify_user_argv_error() {user_argv_error = true;}
     };
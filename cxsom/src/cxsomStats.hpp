@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+
+// This is the number of bins of the task duration histograms. Bin 0
+// counts the tasks lasting less than 1µs, bin b>0 the ones lasting
+// from 2^(b-1) to 2^b µs. The last bin gathers longer tasks.
+#ifndef cxsom_STATS_NB_BINS
+#define cxsom_STATS_NB_BINS 24
+#endif
+
+namespace cxsom {
+  namespace stats {
+
+    // These counters are updated by the workers and read
+    // concurrently, relaxed atomic accesses are enough.
+    using counter = std::atomic<std::uint64_t>;
+    using gauge   = std::atomic<std::int64_t>;
+
+    inline void add(counter& c, std::uint64_t value) {c.fetch_add(value, std::memory_order_relaxed);}
+    inline void add(gauge&   g, std::int64_t  value) {g.fetch_add(value, std::memory_order_relaxed);}
+
+    /**
+     * The tasks executed for one operation.
+     */
+    struct Operation {
+      counter nb_tasks {0};
+      counter duration {0}; //!< ns.
+      std::array<counter, cxsom_STATS_NB_BINS> histogram {};
+
+      void task_done(std::uint64_t ns) {
+	add(nb_tasks, 1);
+	add(duration, ns);
+	add(histogram[std::min<std::size_t>(std::bit_width(ns / 1000), cxsom_STATS_NB_BINS - 1)], 1);
+      }
+    };
+
+    struct Worker {
+      std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+      counter nb_tasks   {0};
+      counter busy       {0}; //!< ns executing tasks.
+      counter scheduling {0}; //!< ns looking for the next task.
+      counter idle       {0}; //!< ns waiting for tasks.
+    };
+
+    /**
+     * The acquisitions of a mutex. An acquisition is contended when
+     * the mutex is already owned.
+     */
+    struct Lock {
+      counter acquisitions {0};
+      counter contended    {0};
+      counter waiting      {0}; //!< ns.
+    };
+
+    /**
+     * This is a std::lock_guard that counts the acquisition. The
+     * waiting time is only measured when the mutex is contended.
+     */
+    template<typename MUTEX>
+    class Guard {
+    private:
+      MUTEX& mutex;
+
+    public:
+      Guard(MUTEX& mutex, Lock& lock) : mutex(mutex) {
+	add(lock.acquisitions, 1);
+	if(!mutex.try_lock()) {
+	  auto start = std::chrono::steady_clock::now();
+	  mutex.lock();
+	  add(lock.contended, 1);
+	  add(lock.waiting, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+      }
+      Guard(const Guard&)            = delete;
+      Guard& operator=(const Guard&) = delete;
+      ~Guard() {mutex.unlock();}
+    };
+
+    /**
+     * The accesses to the instances of a data variable.
+     */
+    struct Variable {
+      counter hits          {0}; //!< Instances found in the cache.
+      counter misses        {0}; //!< Instances built from the file.
+      counter bytes_read    {0};
+      counter bytes_written {0};
+    };
+
+    /**
+     * The timesteps publish their status and queue depths here, per
+     * status (see timestep::status_index).
+     */
+    struct Timesteps {
+      static constexpr std::size_t nb_status = 5;
+      static constexpr std::size_t nb_queues = 5;
+      std::array<gauge, nb_status> count {};
+      std::array<std::array<gauge, nb_queues>, nb_status> depth {};
+    };
+
+    class Registry {
+    private:
+
+      std::mutex mutex;
+      std::map<std::string, std::unique_ptr<Operation>> operations;
+      std::map<std::string, std::unique_ptr<Lock>>      locks;
+      std::vector<std::unique_ptr<Worker>> workers;
+      std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+      Registry() = default;
+
+    public:
+
+      Timesteps timesteps;
+
+      /**
+       * The registry lives as long as the process.
+       */
+      static Registry& get() {
+	static Registry* registry = new Registry();
+	return *registry;
+      }
+
+      /**
+       * The returned reference remains valid, it can be kept to
+       * avoid further lookups.
+       */
+      Operation& operation(const std::string& name) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& res = operations[name];
+	if(!res) res = std::make_unique<Operation>();
+	return *res;
+      }
+
+      /**
+       * As for operations, the returned reference remains valid.
+       */
+      Lock& lock(const std::string& name) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& res = locks[name];
+	if(!res) res = std::make_unique<Lock>();
+	return *res;
+      }
+
+      /**
+       * Each worker thread registers once.
+       */
+      Worker& worker() {
+	std::lock_guard<std::mutex> lock(mutex);
+	workers.push_back(std::make_unique<Worker>());
+	return *(workers.back());
+      }
+
+      double uptime() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+      }
+
+      template<typename Func>
+      void for_each_operation(const Func& f) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto& [name, op] : operations) f(name, *op);
+      }
+
+      template<typename Func>
+      void for_each_lock(const Func& f) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for(auto& [name, l] : locks) f(name, *l);
+      }
+
+      template<typename Func>
+      void for_each_worker(const Func& f) {
+	std::lock_guard<std::mutex> lock(mutex);
+	for(std::size_t id = 0; id < workers.size(); ++id) f(id, *(workers[id]));
+      }
+    };
+  }
+}
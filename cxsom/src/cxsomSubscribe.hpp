@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cxsomData.hpp>
+#include <cxsomSymbols.hpp>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// This is the number of events that a subscriber can have in its
+// queue. The next ones are dropped until it is read.
+#ifndef cxsom_SUBSCRIBE_QUEUE_CAPACITY
+#define cxsom_SUBSCRIBE_QUEUE_CAPACITY 4096
+#endif
+
+namespace cxsom {
+  namespace subscribe {
+
+    /**
+     * This is checked when instances get ready, so that nothing is
+     * done when there is no subscriber.
+     */
+    inline std::atomic<unsigned int> nb_subscribers {0};
+
+    struct Event {
+      symbol::Instance  who;
+      std::vector<char> payload; // Empty if the subscriber only wants notifications.
+    };
+
+    /**
+     * A subscriber receives the events of a timeline, of a single
+     * variable, or of all variables if the timeline is empty. Its
+     * queue is bounded, so that a slow subscriber loses events rather
+     * than slowing down the computation.
+     */
+    class Subscriber {
+    private:
+
+      std::mutex              mutex;
+      std::condition_variable available;
+      std::deque<Event>       events;
+      std::size_t             dropped = 0;
+
+    public:
+
+      const std::string timeline;
+      const std::string name;
+      const bool        with_payload;
+
+      Subscriber(const std::string& timeline, const std::string& name, bool with_payload)
+	: timeline(timeline), name(name), with_payload(with_payload) {}
+
+      bool wants(const symbol::Variable& var) const {
+	return (timeline == "" || timeline == var.timeline) && (name == "" || name == var.name);
+      }
+
+      void push(Event&& e) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(events.size() >= cxsom_SUBSCRIBE_QUEUE_CAPACITY)
+	  ++dropped;
+	else
+	  events.push_back(std::move(e));
+	available.notify_one();
+      }
+
+      /**
+       * This waits for events and moves them into out. It returns the
+       * number of events dropped since the previous call.
+       */
+      std::size_t pop(std::vector<Event>& out) {
+	std::unique_lock<std::mutex> lock(mutex);
+	available.wait(lock, [this]() {return !events.empty() || dropped > 0;});
+	std::move(events.begin(), events.end(), std::back_inserter(out));
+	events.clear();
+	return std::exchange(dropped, 0);
+      }
+
+      /**
+       * As the previous one, but this waits at most for period, so
+       * that out may be left empty.
+       */
+      template<typename DURATION>
+      std::size_t pop(std::vector<Event>& out, const DURATION& period) {
+	std::unique_lock<std::mutex> lock(mutex);
+	available.wait_for(lock, period, [this]() {return !events.empty() || dropped > 0;});
+	std::move(events.begin(), events.end(), std::back_inserter(out));
+	events.clear();
+	return std::exchange(dropped, 0);
+      }
+    };
+
+    class Hub {
+    private:
+
+      std::mutex mutex;
+      std::vector<std::shared_ptr<Subscriber>> subscribers;
+
+      Hub() = default;
+
+    public:
+
+      /**
+       * The hub lives as long as the process, since service threads
+       * are detached.
+       */
+      static Hub& get() {
+	static Hub* hub = new Hub();
+	return *hub;
+      }
+
+      void add(std::shared_ptr<Subscriber> s) {
+	std::lock_guard<std::mutex> lock(mutex);
+	subscribers.push_back(s);
+	nb_subscribers = subscribers.size();
+      }
+
+      void remove(std::shared_ptr<Subscriber> s) {
+	std::lock_guard<std::mutex> lock(mutex);
+	subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), s), subscribers.end());
+	nb_subscribers = subscribers.size();
+      }
+
+      /**
+       * This is called when the instance of var at time at gets ready
+       * with the value d. The value is serialized once, out of the
+       * hub lock, only if some subscriber wants it.
+       */
+      void ready(const symbol::Variable& var, std::size_t at, const data::Base& d) {
+	std::vector<std::shared_ptr<Subscriber>> targets;
+	bool with_payload = false;
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  for(auto& s : subscribers)
+	    if(s->wants(var)) {
+	      targets.push_back(s);
+	      with_payload = with_payload || s->with_payload;
+	    }
+	}
+	if(targets.empty()) return;
+	
+	std::vector<char> payload;
+	if(with_payload) {
+	  payload.resize(d.type->byte_length());
+	  d.write(payload.data());
+	}
+	for(auto& s : targets)
+	  if(s->with_payload) s->push({symbol::Instance(var, at), payload});
+	  else                s->push({symbol::Instance(var, at), {}});
+      }
+    };
+  }
+}
@@ -9,10 +9,15 @@
 #include <sstream>
 #include <iomanip>
 #include <tuple>
+#include <map>
+#include <string>
+#include <algorithm>
 
 #include <cxsomSymbols.hpp>
 #include <cxsomVariable.hpp>
 #include <cxsomUpdate.hpp>
+#include <cxsomTrace.hpp>
+#include <cxsomStats.hpp>
 
 namespace cxsom {
   namespace timestep {
@@ -36,15 +41,165 @@ namespace cxsom {
       return os;
     }
 
+    /**
+     * This is the rank of the status in the statistics.
+     */
+    inline std::size_t status_index(Status s) {
+      switch(s) {
+      case Status::Unbound  : return 0;
+      case Status::Blocked  : return 1;
+      case Status::Relaxing : return 2;
+      case Status::Checking : return 3;
+      case Status::Done     : return 4;
+      }
+      return 0;
+    }
+
     inline std::string to_string(Status s) {
       std::ostringstream ostr;
       ostr << s;
       return ostr.str();
     }
     
+    /**
+     * This is the static analysis of the update graph of a timeline,
+     * computed once from its patterns. There is an edge from u to v
+     * if the result of u is an in-arg of v. The strongly connected
+     * components of the graph are the relaxation loops, they are
+     * ranked in topological order. An update is planned if it is not
+     * in a loop, has no init, and only reads planned updates. An
+     * update is run once its planned predecessors in the graph are
+     * done, so that a planned update has its in-args ready and is
+     * done at its first evaluation. The other updates relax as
+     * usual. The rank only orders the jobs provided at once, it
+     * never holds them back: some in-args may come from other
+     * timelines, which the graph ignores.
+     */
+    class Plan {
+    public:
+      
+      struct Node {
+	std::size_t rank = 0;  //!< The topological rank of the component of the update.
+	bool loop    = false;  //!< true if the update is in a relaxation loop.
+	bool planned = false;
+	std::vector<std::string> preds; //!< The updates of the graph (but itself) which are in-args of the update.
+      };
+      using node_ref = std::shared_ptr<const Node>;
+
+      /**
+       * For each updated variable name, tells whether it has an init, and the names of its in-args.
+       */
+      using graph = std::map<std::string, std::pair<bool, std::vector<std::string>>>;
+      
+    private:
+      
+      std::map<std::string, node_ref> nodes;
+      std::vector<std::vector<std::string>> components; // In topological order.
+
+      // Tarjan's algorithm, components are found in reverse topological order.
+      struct Tarjan {
+	std::map<std::string, std::vector<std::string>> succs;
+	std::map<std::string, std::pair<std::size_t, std::size_t>> idx; // (index, lowlink)
+	std::vector<std::string> stack;
+	std::set<std::string> on_stack;
+	std::vector<std::vector<std::string>> components;
+	std::size_t next = 0;
+
+	Tarjan(const graph& g) {
+	  for(auto& [name, node] : g)
+	    for(auto& arg : node.second)
+	      if(g.find(arg) != g.end()) succs[arg].push_back(name);
+	  for(auto& kv : g)
+	    if(idx.find(kv.first) == idx.end()) visit(kv.first);
+	}
+
+	void visit(const std::string& v) {
+	  idx[v] = {next, next};
+	  ++next;
+	  stack.push_back(v);
+	  on_stack.insert(v);
+	  for(auto& w : succs[v])
+	    if(auto it = idx.find(w); it == idx.end()) {
+	      visit(w);
+	      idx[v].second = std::min(idx[v].second, idx[w].second);
+	    }
+	    else if(on_stack.find(w) != on_stack.end())
+	      idx[v].second = std::min(idx[v].second, it->second.first);
+	  if(idx[v].second == idx[v].first) {
+	    std::vector<std::string> component;
+	    std::string w;
+	    do {
+	      w = stack.back();
+	      stack.pop_back();
+	      on_stack.erase(w);
+	      component.push_back(w);
+	    } while(w != v);
+	    components.push_back(std::move(component));
+	  }
+	}
+      };
+      
+    public:
+
+      Plan()                       = default;
+      Plan(const Plan&)            = default;
+      Plan& operator=(const Plan&) = default;
+
+      Plan(const graph& g) {
+	Tarjan tarjan(g);
+	std::size_t rank = 0;
+	for(auto cit = tarjan.components.rbegin(); cit != tarjan.components.rend(); ++cit, ++rank) {
+	  auto& component = *cit;
+	  bool loop = component.size() > 1;
+	  if(!loop) {
+	    auto& args = g.at(component.front()).second;
+	    loop = std::find(args.begin(), args.end(), component.front()) != args.end();
+	  }
+	  for(auto& name : component) {
+	    auto& [has_init, args] = g.at(name);
+	    bool planned = !loop && !has_init;
+	    std::vector<std::string> preds;
+	    for(auto& arg : args) {
+	      if(auto it = nodes.find(arg); it != nodes.end()) planned = planned && it->second->planned;
+	      if(arg != name && g.find(arg) != g.end() && std::find(preds.begin(), preds.end(), arg) == preds.end()) preds.push_back(arg);
+	    }
+	    nodes[name] = std::make_shared<Node>(Node {rank, loop, planned, std::move(preds)});
+	  }
+	  components.emplace_back(component.rbegin(), component.rend());
+	}
+      }
+
+      /**
+       * @returns nullptr if the variable is not updated by the plan.
+       */
+      node_ref operator()(const std::string& varname) const {
+	if(auto it = nodes.find(varname); it != nodes.end()) return it->second;
+	return nullptr;
+      }
+
+      friend std::ostream& operator<<(std::ostream& os, const Plan& plan);
+    };
+
+    inline std::ostream& operator<<(std::ostream& os, const Plan& plan) {
+      std::size_t rank = 0;
+      for(auto& component : plan.components) {
+	os << "  #" << rank++ << ' ';
+	auto node = plan(component.front());
+	if(node->loop)         os << "loop    {";
+	else if(node->planned) os << "planned {";
+	else                   os << "        {";
+	auto it = component.begin();
+	os << *(it++);
+	while(it != component.end()) os << ", " << *(it++);
+	os << '}' << std::endl;
+      }
+      return os;
+    }
+    
     struct content {
       update::ref init;
       update::ref usual;
+      Plan::node_ref plan = nullptr; //!< nullptr if the update is not from a pattern.
       bool no_processing = true;
       void init_done() {init = nullptr;}
       bool has_init() const {return init != nullptr;}
@@ -52,8 +207,9 @@ namespace cxsom {
       content()                          = delete;
       content(const content&)            = default;
       content& operator=(const content&) = default;
-      content(update::ref usual) : init(), usual(usual), no_processing(true) {usual->is_init = false;}
-      content(update::ref init, update::ref usual) : init(init), usual(usual), no_processing(true) {init->is_init = true; usual->is_init = false;}
+      content(update::ref usual) : init(), usual(usual), plan(), no_processing(true) {usual->is_init = false;}
+      content(update::ref init, update::ref usual) : init(init), usual(usual), plan(), no_processing(true) {init->is_init = true; usual->is_init = false;}
+      std::size_t rank() const {return plan ? plan->rank : 0;}
       operator bool() const {return (bool)usual;}
       const std::string& varname() const {return usual->result.who.variable.name;}
       bool operator==(const std::string& name) const {return varname() == name;}
@@ -99,6 +255,13 @@ namespace cxsom {
       return ostr.str();
     }
 
+    /**
+     * This is the initial of the queue name, used in traces.
+     */
+    inline char queue_code(Queue q) {
+      return to_string(q)[0];
+    }
+
     struct Task {
       ref                           step;
       content                       update;
@@ -167,8 +330,7 @@ namespace cxsom {
 #endif
 
 		  // Let us check the status of arg.
-		  data::Availability arg_status;
-		  arg.what->get([&arg_status](auto status, auto, auto&) {arg_status = status;});
+		  data::Availability arg_status = arg.what->get_status();
 		  
 		  switch(arg_status) {
 		  case data::Availability::Busy:	
@@ -254,9 +416,62 @@ namespace cxsom {
       std::array<std::list<content>, cxsomTIME_STEP_NB_QUEUES> queues;
       UnboundManager unbound_manager;
 
+      // These are the status and queue depths counted in the statistics.
+      std::size_t published_status;
+      std::array<std::size_t, cxsomTIME_STEP_NB_QUEUES> published_depth {};
+
+      // This updates the statistics with the current status and queue depths.
+      void publish_stats() {
+	auto& gauges = stats::Registry::get().timesteps;
+	auto s = status_index(status);
+	if(s != published_status) {
+	  stats::add(gauges.count[published_status], -1);
+	  stats::add(gauges.count[s], 1);
+	}
+	for(std::size_t q = 0; q < cxsomTIME_STEP_NB_QUEUES; ++q) {
+	  std::size_t depth = queues[q].size();
+	  if(s != published_status || depth != published_depth[q]) {
+	    stats::add(gauges.depth[published_status][q], -static_cast<std::int64_t>(published_depth[q]));
+	    stats::add(gauges.depth[s][q], static_cast<std::int64_t>(depth));
+	    published_depth[q] = depth;
+	  }
+	}
+	published_status = s;
+      }
+
+      bool plan_enabled = true;                           // false as soon as an update which is not from a pattern is added.
+      std::set<std::string> pending_planned;              // The planned updates which are not evaluated yet.
+
+      // An update waits for its pending planned predecessors.
+      bool held_back(const content& update) const {
+	if(!plan_enabled || !update.plan) return false;
+	for(auto& pred : update.plan->preds)
+	  if(pending_planned.find(pred) != pending_planned.end()) return true;
+	return false;
+      }
+
+      // Jobs are provided by increasing plan rank, except those which are held back.
+      template<typename TaksOutputIt>
+      bool ranked_jobs(ref that, Queue source, TaksOutputIt& out) {
+	std::vector<std::list<content>::iterator> jobs;
+	auto& queue = queues[static_cast<unsigned int>(source)];
+	for(auto it = queue.begin(); it != queue.end(); ++it)
+	  if(it->no_processing && !held_back(*it)) jobs.push_back(it);
+	std::stable_sort(jobs.begin(), jobs.end(), [](auto a, auto b) {return a->rank() < b->rank();});
+	for(auto it : jobs) *(out++) = {that, *it, source};
+	return jobs.size() > 0;
+      }
+
 
 
       void move_queue_content(Queue from, Queue to) {
+	if(auto size = queues[static_cast<unsigned int>(from)].size(); size > 0)
+	  trace::instant(trace::Event::QueueMove, [this, from, to, size](auto& r) {
+	      r.label(who.timeline, "", who.at);
+	      r.count   = size;
+	      r.info[0] = queue_code(from);
+	      r.info[1] = queue_code(to);
+	    });
 	std::copy(queues[static_cast<unsigned int>(from)].begin(),
 		  queues[static_cast<unsigned int>(from)].end(),
 		  std::back_inserter(queues[static_cast<unsigned int>(to)]));
@@ -350,17 +565,25 @@ namespace cxsom {
     public:
 
       Instance()                           = delete;
-      Instance(const Instance&)            = default;
-      Instance& operator=(const Instance&) = default;
-      Instance(Instance&&)                 = default;
-      Instance& operator=(Instance&&)      = default;
+      Instance(const Instance&)            = delete;
+      Instance& operator=(const Instance&) = delete;
+      Instance(Instance&&)                 = delete;
+      Instance& operator=(Instance&&)      = delete;
 
-      Instance(const symbol::TimeStep& who) : who(who) {
+      Instance(const symbol::TimeStep& who) : who(who), published_status(status_index(status)) {
+	stats::add(stats::Registry::get().timesteps.count[published_status], 1);
 #ifdef cxsomMONITOR
 	monitor->timestep_launch(who, to_string(status));
 #endif
       }
 
+      ~Instance() {
+	auto& gauges = stats::Registry::get().timesteps;
+	stats::add(gauges.count[published_status], -1);
+	for(std::size_t q = 0; q < cxsomTIME_STEP_NB_QUEUES; ++q)
+	  stats::add(gauges.depth[published_status][q], -static_cast<std::int64_t>(published_depth[q]));
+      }
+
       void notify_update_to_monitor(Monitor::TimeStepUpdateReason why) {
 	
 	std::vector<symbol::Instance> new_content;
@@ -423,6 +646,7 @@ namespace cxsom {
 	
 	move_queue_content(Queue::Impossible, Queue::Unstable);
 	status = Status::Relaxing;
+	publish_stats();
 #ifdef cxsomLOG
 	logger->pop();
 #endif
@@ -443,6 +667,7 @@ namespace cxsom {
 	  logger->push();
 #endif
 	  update_status(notify_done);
+	  publish_stats();
 #ifdef cxsomLOG
 	  logger->pop();
 #endif
@@ -488,7 +713,15 @@ namespace cxsom {
        * Adds an update without any test (should be done before by test_add).
        */
       void add(const content& update) {
+	if(!update.plan) {
+	  // The plan of the timeline may not describe this timestep anymore.
+	  plan_enabled = false;
+	  pending_planned.clear();
+	}
+	else if(plan_enabled && update.plan->planned)
+	  pending_planned.insert(update.varname());
 	queues[static_cast<unsigned int>(Queue::New)].push_back(update);
+	publish_stats();
 #ifdef cxsomMONITOR
 	notify_update_to_monitor(Monitor::TimeStepUpdateReason::NewUpdate);
 #endif
@@ -508,6 +741,7 @@ namespace cxsom {
 					       queues[static_cast<unsigned int>(Queue::Unstable)],
 					       variables))
 	  status = Status::Unbound;
+	publish_stats();
 #ifdef cxsomMONITOR
 	  notify_update_to_monitor(Monitor::TimeStepUpdateReason::Unbound);
 	  monitor->clear_unbounds();
@@ -556,6 +790,12 @@ namespace cxsom {
 	content update = task.update;
 	remove_update(update.varname());
 
+	// A planned update which is not done at its first evaluation
+	// (e.g. an in-arg from another timeline is busy) relaxes as the
+	// others, nobody waits for it anymore.
+	if(update.plan && update.plan->planned)
+	  pending_planned.erase(update.varname());
+
 #ifdef cxsomMONITOR
 	{
 	  std::ostringstream ostr;
@@ -628,6 +868,7 @@ namespace cxsom {
 	
 #ifdef cxsomLOG
 	auto res = update_status(notify_done);
+	publish_stats();
 	{
 	  std::ostringstream ostr;
 	  ostr << "End of reporting, returning " << res << '.';
@@ -636,7 +877,9 @@ namespace cxsom {
 	}
 	return res;
 #else
-	return update_status(notify_done);
+	auto res = update_status(notify_done);
+	publish_stats();
+	return res;
 #endif
       }
 
@@ -647,7 +890,6 @@ namespace cxsom {
       template<typename TaksOutputIt>
       bool get_jobs(ref that, TaksOutputIt out) {
 	bool res = false;
-	std::list<content>::iterator end;
 
 	this->check_unbound();
 	
@@ -661,18 +903,8 @@ namespace cxsom {
 #endif
 	switch(status) {
 	case Status::Relaxing :
-	  end = queues[static_cast<unsigned int>(Queue::Unstable)].end();
-	  for(auto it = queues[static_cast<unsigned int>(Queue::Unstable)].begin(); it != end; ++it)
-	    if(it->no_processing) {
-	      res = true;
-	      *(out++) = {that, *it, Queue::Unstable};
-	    }
-	  end = queues[static_cast<unsigned int>(Queue::Stable)].end();
-	  for(auto it = queues[static_cast<unsigned int>(Queue::Stable)].begin(); it != end; ++it)
-	    if(it->no_processing) {
-	      res = true;
-	      *(out++) = {that, *it, Queue::Stable};
-	    }
+	  res = ranked_jobs(that, Queue::Unstable, out);
+	  res = ranked_jobs(that, Queue::Stable,   out) || res;
 #ifdef cxsomLOG
 	  if(res) logger->msg("found some jobs in \"unstable\" or \"stable\" queue.");
 	  else    logger->msg("found no jobs in \"unstable\" nor in \"stable\" queue.");
@@ -681,12 +913,7 @@ namespace cxsom {
 	  return res;
 	  break;
 	case Status::Checking :
-	  end = queues[static_cast<unsigned int>(Queue::Stable)].end();
-	  for(auto it = queues[static_cast<unsigned int>(Queue::Stable)].begin(); it != end; ++it)
-	    if(it->no_processing) {
-	      res = true;
-	      *(out++) = {that, *it, Queue::Stable};
-	    }
+	  res = ranked_jobs(that, Queue::Stable, out);
 #ifdef cxsomLOG
 	  if(res) logger->msg("found some jobs in \"stable\" queue.");
 	  else    logger->msg("found no jobs in \"stable\" queue.");
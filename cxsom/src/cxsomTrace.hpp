@@ -0,0 +1,266 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// This is the number of events kept by each thread while tracing is
+// on. It must be a power of 2. The oldest events are overwritten when
+// the ring is full.
+#ifndef cxsom_TRACE_RING_SIZE
+#define cxsom_TRACE_RING_SIZE 65536
+#endif
+
+namespace cxsom {
+  namespace trace {
+
+    /**
+     * Tracing is switched on and off at runtime. When it is off,
+     * recording an event only costs the test of this flag.
+     */
+    inline std::atomic<bool> active {false};
+
+    enum class Event : std::uint8_t {
+      Task,       //!< The execution of an update task, info[0] is the report.
+      QueueMove,  //!< Updates of a timestep moved from queue info[0] to queue info[1].
+      Blocked,    //!< A timestep got count new blockers.
+      Unblocked,  //!< A timestep is done, count timesteps waiting for it are notified.
+      FileRead,   //!< The payload of an instance is read from its file.
+      FileWrite   //!< count instances are written into their file.
+    };
+
+    /**
+     * This is a binary event, it fits a cache line.
+     */
+    struct Record {
+      std::uint64_t begin;    //!< ns since tracing has been started.
+      std::uint64_t duration; //!< ns, 0 for instant events.
+      std::uint32_t at;
+      std::uint32_t count;
+      Event         event;
+      char          info[3];
+      char          name[36]; //!< timeline/name, truncated.
+
+      void label(const std::string& timeline, const std::string& var_name, std::size_t date) {
+	at = static_cast<std::uint32_t>(date);
+	std::size_t n = std::min(timeline.size(), sizeof(name) - 1);
+	std::memcpy(name, timeline.data(), n);
+	if(var_name.size() > 0 && n < sizeof(name) - 1) {
+	  name[n++] = '/';
+	  std::size_t m = std::min(var_name.size(), sizeof(name) - 1 - n);
+	  std::memcpy(name + n, var_name.data(), m);
+	  n += m;
+	}
+	name[n] = '\0';
+      }
+    };
+
+    /**
+     * Each thread records into its own ring, so recording needs no
+     * lock. The ring of a thread that exits is given to the next new
+     * thread.
+     */
+    class Ring {
+    private:
+      friend class Tracer;
+
+      std::vector<Record> records;
+      std::atomic<std::uint64_t> head {0};
+      bool owned = true;
+
+    public:
+      const unsigned int id;
+
+      Ring(unsigned int id) : records(cxsom_TRACE_RING_SIZE), id(id) {}
+
+      void push(const Record& r) {
+	auto h = head.load(std::memory_order_relaxed);
+	records[h & (cxsom_TRACE_RING_SIZE - 1)] = r;
+	head.store(h + 1, std::memory_order_release);
+      }
+    };
+
+    class Tracer {
+    private:
+
+      std::mutex mutex;
+      std::vector<std::unique_ptr<Ring>> rings;
+      std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+      Tracer() = default;
+
+      struct Owner {
+	Ring* ring = nullptr;
+	~Owner() {if(ring) Tracer::get().retire(ring);}
+      };
+
+      Ring& ring() {
+	thread_local Owner owner;
+	if(!owner.ring) {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  for(auto& r : rings)
+	    if(!r->owned) {r->owned = true; owner.ring = r.get(); break;}
+	  if(!owner.ring) {
+	    rings.push_back(std::make_unique<Ring>(rings.size()));
+	    owner.ring = rings.back().get();
+	  }
+	}
+	return *owner.ring;
+      }
+
+      void retire(Ring* r) {
+	std::lock_guard<std::mutex> lock(mutex);
+	r->owned = false;
+      }
+
+      static void escaped(std::ostream& os, const char* s) {
+	for(; *s != '\0'; ++s) {
+	  if(*s == '"' || *s == '\\') os << '\\';
+	  if(static_cast<unsigned char>(*s) >= ' ') os << *s;
+	}
+      }
+
+      static void write(std::ostream& os, const Record& r, unsigned int tid) {
+	os << "{\"pid\":1,\"tid\":" << tid << ",\"ts\":" << r.begin / 1000 << '.' << r.begin % 1000 / 100;
+	switch(r.event) {
+	case Event::Task:
+	  os << ",\"ph\":\"X\",\"cat\":\"task\",\"dur\":" << r.duration / 1000 << '.' << r.duration % 1000 / 100
+	     << ",\"name\":\""; escaped(os, r.name);
+	  os << '@' << r.at << "\",\"args\":{\"report\":\"" << r.info[0] << "\"}}";
+	  break;
+	case Event::FileRead:
+	case Event::FileWrite:
+	  os << ",\"ph\":\"X\",\"cat\":\"io\",\"dur\":" << r.duration / 1000 << '.' << r.duration % 1000 / 100
+	     << ",\"name\":\"" << (r.event == Event::FileRead ? "read " : "write "); escaped(os, r.name);
+	  os << "\",\"args\":{\"at\":" << r.at << ",\"count\":" << r.count << "}}";
+	  break;
+	case Event::QueueMove:
+	  os << ",\"ph\":\"i\",\"s\":\"t\",\"cat\":\"queue\",\"name\":\"" << r.info[0] << " -> " << r.info[1]
+	     << "\",\"args\":{\"timestep\":\""; escaped(os, r.name);
+	  os << '@' << r.at << "\",\"count\":" << r.count << "}}";
+	  break;
+	case Event::Blocked:
+	case Event::Unblocked:
+	  os << ",\"ph\":\"i\",\"s\":\"t\",\"cat\":\"blocking\",\"name\":\"" << (r.event == Event::Blocked ? "blocked" : "unblocks")
+	     << "\",\"args\":{\"timestep\":\""; escaped(os, r.name);
+	  os << '@' << r.at << "\",\"count\":" << r.count << "}}";
+	  break;
+	}
+      }
+
+    public:
+
+      /**
+       * The tracer lives as long as the process, since threads may
+       * retire their ring at exit.
+       */
+      static Tracer& get() {
+	static Tracer* tracer = new Tracer();
+	return *tracer;
+      }
+
+      std::uint64_t now() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+      }
+
+      void push(const Record& r) {ring().push(r);}
+
+      /**
+       * This forgets previous events and starts recording.
+       */
+      void start() {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  for(auto& r : rings) r->head = 0;
+	  origin = std::chrono::steady_clock::now();
+	}
+	active = true;
+      }
+
+      void stop() {active = false;}
+
+      /**
+       * This writes the recorded events in the Chrome trace JSON
+       * format, which Perfetto reads as well. Each thread ring is a
+       * track.
+       */
+      void write_chrome(std::ostream& os) {
+	std::lock_guard<std::mutex> lock(mutex);
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	std::vector<Record> records;
+	for(auto& r : rings) {
+	  auto end = r->head.load(std::memory_order_acquire);
+	  auto begin = end > cxsom_TRACE_RING_SIZE ? end - cxsom_TRACE_RING_SIZE : 0;
+	  records.clear();
+	  for(auto h = begin; h != end; ++h) records.push_back(r->records[h & (cxsom_TRACE_RING_SIZE - 1)]);
+	  // The ring may have been written meanwhile, overwritten events are skipped.
+	  auto last = r->head.load(std::memory_order_acquire);
+	  auto skip = last > cxsom_TRACE_RING_SIZE + begin ? std::min<std::uint64_t>(last - cxsom_TRACE_RING_SIZE - begin, records.size()) : 0;
+	  for(auto it = records.begin() + skip; it != records.end(); ++it) {
+	    if(!first) os << ',';
+	    first = false;
+	    os << '\n';
+	    write(os, *it, r->id);
+	  }
+	}
+	os << "\n]}" << std::endl;
+      }
+    };
+
+    /**
+     * This records an instant event. The label is set by the caller
+     * from the returned record, so it is only computed when tracing
+     * is on.
+     */
+    template<typename Fill>
+    inline void instant(Event event, const Fill& fill) {
+      if(!active.load(std::memory_order_relaxed)) return;
+      auto& tracer = Tracer::get();
+      Record r {};
+      r.begin = tracer.now();
+      r.event = event;
+      fill(r);
+      tracer.push(r);
+    }
+
+    /**
+     * This records an event lasting from its construction to its
+     * destruction. Test it before labelling.
+     */
+    class Span {
+    private:
+      Record r;
+      bool on;
+
+    public:
+      Span(Event event) : on(active.load(std::memory_order_relaxed)) {
+	if(on) {
+	  r = Record {};
+	  r.event = event;
+	  r.begin = Tracer::get().now();
+	}
+      }
+      Span(const Span&)            = delete;
+      Span& operator=(const Span&) = delete;
+
+      ~Span() {
+	if(on) {
+	  auto& tracer = Tracer::get();
+	  r.duration = tracer.now() - r.begin;
+	  tracer.push(r);
+	}
+      }
+
+      explicit operator bool() const {return on;}
+      Record* operator->() {return &r;}
+    };
+  }
+}
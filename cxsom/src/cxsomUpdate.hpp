@@ -6,6 +6,7 @@
 #include <initializer_list>
 #include <cxsomSymbols.hpp>
 #include <cxsomVariable.hpp>
+#include <cxsomStats.hpp>
 #include <map>
 #include <iostream>
 #include <tuple>
@@ -37,7 +38,8 @@ namespace cxsom {
       return os;
     }
     
-    using arg = std::tuple<symbol::Instance, type::ref>;
+    using arg       = std::tuple<symbol::Instance, type::ref>;
+    using bound_arg = std::tuple<symbol::Instance, data::instance_ref>;
     
     /**
      * This is a rule for setting one instance value from other instances.
@@ -237,18 +239,53 @@ namespace cxsom {
 	
 	// Let us now build the instances.
 	result = {std::get<0>(res), center[std::get<0>(res)]};
-	auto res_time_step = (symbol::TimeStep)(std::get<0>(res));
-	auto out_in  = std::back_inserter(args_in );
-	auto out_out = std::back_inserter(args_out);
 	unsigned int arg_id = 0;
-	for(auto& arg : args)
-	  if((symbol::TimeStep)(std::get<0>(arg)) == res_time_step)
-	    *(out_in++)  = {std::get<0>(arg), center[std::get<0>(arg)], arg_id++};
-	  else
-	    *(out_out++) = {std::get<0>(arg), center[std::get<0>(arg)], arg_id++};
-	
+	for(auto& arg : args) add_arg(std::get<0>(arg), center[std::get<0>(arg)], arg_id++);
+      }
+
+      /**
+       * This binds a recycled update to the instances of another
+       * timestep (see jobs::Center). The instances are already
+       * fetched and their types are not checked again. The buffers
+       * of the operation are kept, only its per-timestep state is
+       * reset (see on_rebind).
+       */
+      void rebind(const bound_arg& res,
+		  const std::vector<bound_arg>& args) {
+	unbind();
+	result = {std::get<0>(res), std::get<1>(res)};
+	unsigned int arg_id = 0;
+	for(auto& arg : args) add_arg(std::get<0>(arg), std::get<1>(arg), arg_id++);
+	on_rebind();
+      }
+
+      /**
+       * This releases the instances, so that they can leave the cache
+       * of their variables.
+       */
+      void unbind() {
+	result = ResInstance();
+	args_in.clear();
+	args_out.clear();
+	blockers.clear();
+	out_ok = false;
+      }
+
+      bool is_bound() const {return (bool)(result.what);}
+
+    private:
+
+      // Arguments in the timestep of the result are in-args, the other ones are out-args.
+      void add_arg(const symbol::Instance& who, data::instance_ref what, unsigned int arg_id) {
+	const auto& res = result.who;
+	if(who.at == res.at && who.variable.timeline == res.variable.timeline)
+	  args_in.emplace_back(who, what, arg_id);
+	else
+	  args_out.emplace_back(who, what, arg_id);
       }
 
+    public:
+
       using blockers_iter_type = std::vector<symbol::TimeStep>::iterator;
       std::pair<blockers_iter_type, blockers_iter_type> blockers_range() const {
 	blockers.clear();
@@ -400,6 +437,12 @@ namespace cxsom {
     public:
       virtual std::string function_name() const {return "<undocumented>";}
 
+      /**
+       * These are the statistics of the function, they are found from
+       * its name at the first execution.
+       */
+      stats::Operation* operation_stats = nullptr;
+
       /**
        * This reconsiders the availability of the arguments from the variable files.
        */
@@ -474,6 +517,13 @@ namespace cxsom {
       
     protected:
 
+      /**
+       * This is called when the update is rebound to another
+       * timestep. Overload it if the operation keeps a state from one
+       * computation to the next.
+       */
+      virtual void on_rebind() {}
+      
       /**
        * This is calld at computation start
        */
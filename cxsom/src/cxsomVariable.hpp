@@ -13,16 +13,42 @@
 #include <algorithm>
 
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <condition_variable>
 #include <atomic>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <array>
+#include <functional>
+#include <sstream>
+#include <list>
+
+#include <sys/resource.h>
 
 #include <cxsomData.hpp>
 #include <cxsomSymbols.hpp>
+#include <cxsomTrace.hpp>
+#include <cxsomStats.hpp>
+#include <cxsomSubscribe.hpp>
 
 #include <filesystem>
 namespace fs = std::filesystem;
 
+// The variables of a data::Center are spread over that many
+// independently locked shards.
+#ifndef cxsom_NB_CENTER_SHARDS
+#define cxsom_NB_CENTER_SHARDS 16
+#endif
+
+// This is the maximal number of variable files that are not kept
+// opened but stay opened in the descriptor pool (see
+// data::FilePool). It is lowered to half of RLIMIT_NOFILE if needed.
+#ifndef cxsom_FILE_POOL_SIZE
+#define cxsom_FILE_POOL_SIZE 512
+#endif
+
 #define cxsom_UINT_LENGTH                  8
 
 #define cxsom_LENGTH_TYPE_IN_FILE          64
@@ -38,6 +64,11 @@ namespace fs = std::filesystem;
 #define cxsom_OFFSET_NEXT_FREE_POS_IN_FILE (cxsom_OFFSET_HIGHEST_TIME_IN_FILE  + cxsom_LENGTH_HIGHEST_TIME_IN_FILE )
 #define cxsom_OFFSET_HEADER_IN_FILE        (cxsom_OFFSET_NEXT_FREE_POS_IN_FILE + cxsom_LENGTH_NEXT_FREE_POS_IN_FILE)
 
+// The last byte of the type area tells the slot layout (0 for legacy files).
+#define cxsom_OFFSET_LAYOUT_IN_FILE         (cxsom_OFFSET_TYPE_IN_FILE + cxsom_LENGTH_TYPE_IN_FILE - 1)
+#define cxsom_OFFSET_ALIGNED_HEADER_IN_FILE 128
+#define cxsom_SLOT_ALIGNMENT                64
+
 
 
 //#define cxsomDEBUG_VARFILE
@@ -91,6 +122,85 @@ namespace cxsom {
       return Availability::Ready;
     }
 
+    /**
+     * This is how slots are stored in a .var file.
+     */
+    enum class Layout : char {
+			      Packed  = 0, //!< Slots are [ready byte | payload], right after the header.
+			      Aligned = 1  //!< Slots are [payload | ready byte | padding], 64-byte aligned, from offset 128.
+    };
+    
+    inline std::ostream& operator<<(std::ostream& os, Layout l) {
+      switch(l) {
+      case Layout::Packed : os << "packed" ; break;
+      case Layout::Aligned: os << "aligned"; break;
+      }
+      
+      return os;
+    }
+
+    /**
+     * The layout of newly created files. Existing files keep their own layout.
+     */
+#ifdef cxsomALIGNED_VARFILES
+    constexpr Layout default_layout = Layout::Aligned;
+#else
+    constexpr Layout default_layout = Layout::Packed;
+#endif
+
+    class File;
+
+    /**
+     * The files of the variables that are not kept opened are opened
+     * when they are accessed, and then stay opened in this
+     * process-wide pool. When the pool is full, the least recently
+     * used files that are not being accessed are closed.
+     */
+    class FilePool {
+    private:
+      std::mutex mutex;
+      std::list<File*> files; // The most recently used first.
+      std::size_t capacity;
+
+      FilePool() : capacity(cxsom_FILE_POOL_SIZE) {
+	if(struct rlimit rl; getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+	  capacity = std::min(capacity, std::max(std::size_t(1), std::size_t(rl.rlim_cur / 2)));
+      }
+
+      void evict();
+      
+    public:
+
+      static FilePool& get() {
+	static FilePool pool;
+	return pool;
+      }
+
+      void set_capacity(std::size_t capacity) {
+	std::lock_guard<std::mutex> lock(mutex);
+	this->capacity = std::max(std::size_t(1), capacity);
+	evict();
+      }
+
+      /**
+       * The file is opened if needed, and it cannot be closed by the
+       * pool until it is released.
+       */
+      void acquire(File& f);
+      void release(File& f);
+
+      /**
+       * The file leaves the pool, it is not closed.
+       */
+      void forget(File& f);
+
+      /**
+       * The file is closed, unless it is in the pool (the pool closes
+       * it then).
+       */
+      void close_unpooled(File& f);
+    };
+    
     class File {
     public:
       static std::size_t no_time() {return std::numeric_limits<std::size_t>::max();}
@@ -119,36 +229,40 @@ namespace cxsom {
       
     private:
 
+      friend class FilePool;
+      
       class WithFile {
       private:
-	std::fstream& file;
-	bool was_closed;
+	File& f;
 
       public:
-	WithFile(std::fstream& file,
-		 const fs::path& p) : file(file), was_closed(!(file.is_open())) {
-	  if(was_closed) {    
-	    file.clear();
-	    file.open(p.c_str(), std::ios::out | std::ios::in);
-	  }
-	}
-	
-	~WithFile() {
-	  if(was_closed) 
-	    file.close();
-	}
+	WithFile(File& f) : f(f) {if(!f.kept_opened) FilePool::get().acquire(f);}
+	~WithFile()              {if(!f.kept_opened) FilePool::get().release(f);}
       };
 	
+      // These are handled by the FilePool.
+      bool kept_opened = false;
+      bool pooled      = false;
+      unsigned int nb_users = 0;
+      std::list<File*>::iterator in_pool;
+      
+
       mutable std::fstream file;
       const symbol::Variable var_symb;
       type::ref type;
       std::size_t cache_size;
       std::size_t file_size;
       std::size_t data_size;
+      std::size_t data_offset;    // The file position of the first slot.
+      std::size_t ready_offset;   // The position of the ready byte in a slot.
+      std::size_t payload_offset; // The position of the payload in a slot.
+      Layout layout;
       std::size_t highest_time;
       std::size_t next_free_pos;
       fs::path var_path;
       bool realized;
+      bool in_memory = false;
+      bool header_deferred = false;
       
       
       void read_uint(std::size_t& nb) {
@@ -186,12 +300,45 @@ namespace cxsom {
       }
 				    
 
-      // This seeks at a position (not checked) in the buffer.
+      // This returns the file position of a slot (not checked) in the buffer.
+      std::size_t slot_pos_htma(std::size_t highest_time_minus_at) const {
+	return data_offset + pos_in_past(next_free_pos, highest_time_minus_at, file_size) * data_size;
+      }
+
+      // This seeks at the ready byte of a position (not checked) in the buffer.
       void seekg(std::size_t at) {seekg_htma(highest_time - at);}
       
-      // This seeks at a position (not checked) in the buffer.
+      // This seeks at the ready byte of a position (not checked) in the buffer.
       void seekg_htma(std::size_t highest_time_minus_at) {
-	file.seekg(cxsom_OFFSET_HEADER_IN_FILE + pos_in_past(next_free_pos, highest_time_minus_at, file_size) * data_size);
+	file.seekg(slot_pos_htma(highest_time_minus_at) + ready_offset);
+      }
+
+      // This stores highest_time and next_free_pos in the file, unless a batch writing is in progress.
+      void write_header() {
+	if(header_deferred) return;
+	file.seekp(cxsom_OFFSET_HIGHEST_TIME_IN_FILE, std::ios_base::beg);  write_uint(highest_time);
+	file.seekp(cxsom_OFFSET_NEXT_FREE_POS_IN_FILE, std::ios_base::beg); write_uint(next_free_pos);
+	file << std::flush;
+      }
+
+      // We write the content before marking it as ready, so that
+      // file readers cannot consider a file chunk readable while it
+      // is currently beeing filled. Aligned slots are written with
+      // their padding, so that the file always contains whole slots.
+      void write_slot(std::size_t slot_pos, data::ref d) {
+	file.seekp(slot_pos, std::ios_base::beg);
+	if(layout == Layout::Packed) {
+	  file.put(static_cast<char>(Availability::Busy));
+	  d->write(file);
+	}
+	else {
+	  d->write(file);
+	  file.put(static_cast<char>(Availability::Busy));
+	  for(std::size_t p = ready_offset + 1; p < data_size; ++p) file.put(0);
+	}
+	file << std::flush;
+	file.seekp(slot_pos + ready_offset, std::ios_base::beg);
+	file.put(static_cast<char>(Availability::Ready));
       }
       
     public:
@@ -204,14 +351,19 @@ namespace cxsom {
 	  var_path(root_path / var_symb.timeline / (var_symb.name + ".var")),
 	  realized(false) {
 	file.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
-	auto d = var_path;
-	d.remove_filename();
-	if(!fs::exists(d)) fs::create_directories(d);
 #ifdef cxsomDEBUG_VARFILE
 	std::cout << "[varfile " << var_path << "] Definition." << std::endl;
 #endif
       }
 
+      File(const File&) = delete;
+      File(File&&)      = delete;
+      File& operator=(const File&) = delete;
+      
+      ~File() {
+	FilePool::get().forget(*this);
+      }
+
       /**
        * Tells wether the file is already there.
        */
@@ -228,6 +380,8 @@ namespace cxsom {
 
       type::ref get_type() const {return type;}
 
+      Layout get_layout() const {return layout;}
+
       std::size_t get_next_time() const {
 	if(highest_time == no_time())
 	  return 0;
@@ -279,14 +433,16 @@ namespace cxsom {
        * @param type If not nullptr, it defines the type of the variable. If not nullprt, it should fit the existing type in the file when the file already exists.
        * @param cache_size The size of the data instance cache. It is updated in the file if not std::nullopt.
        * @param file_size The size of the circular buffer stored in the file. It is updated read if the file exists, so a non std::nullopt in this case is ignored.
-       * @param kept_opened If true, the file is kept opened for further use. Be sure you do not have too many (> 1024) files kept opened during your simulation, Linux limits this.
+       * @param kept_opened If true, the file is kept opened for further use. Be sure you do not have too many (> 1024) files kept opened during your simulation, Linux limits this. Otherwise, the file descriptor is handled by the FilePool.
+       * @param layout The slot layout, used only when the file is created. The layout of an existing file is read from it.
        */
       void realize(type::ref type,
 		   std::optional<std::size_t> cache_size,
 		   std::optional<std::size_t> file_size,
-		   bool kept_opened) {
+		   bool kept_opened,
+		   Layout layout = default_layout) {
 	if(fs::exists(var_path)) {
-	  WithFile with_file(file, var_path);
+	  WithFile with_file(*this);
 
 	  // Checking type
 	  std::string type_name;
@@ -300,6 +456,15 @@ namespace cxsom {
 	    throw error::type_mismatch(ostr.str());
 	  }
 
+	  // Getting layout
+	  file.seekg(cxsom_OFFSET_LAYOUT_IN_FILE, std::ios_base::beg);
+	  this->layout = static_cast<Layout>(file.get());
+	  if(this->layout != Layout::Packed && this->layout != Layout::Aligned) {
+	    std::ostringstream ostr;
+	    ostr << "cxsom::data::File::check : " << var_path << " has an unknown slot layout " << static_cast<int>(this->layout) << ".";
+	    throw error::file(ostr.str());
+	  }
+
 	  // Setting/getting cache_size
 	  if(cache_size) {
 	    this->cache_size = *cache_size;
@@ -336,6 +501,7 @@ namespace cxsom {
 #endif
 	}
 	else {
+	  FilePool::get().forget(*this); // The pool doesn't close it anymore.
 	  if(file.is_open()) // May never happen...
 	    file.close();
 	  
@@ -355,6 +521,9 @@ namespace cxsom {
 	    throw error::file(msg.str());
 	  }
 	  
+	  auto d = var_path;
+	  d.remove_filename();
+	  if(!fs::exists(d)) fs::create_directories(d);
 	  file.clear();
 	  file.open(var_path, std::ios::out); // Creates the file.
 	  
@@ -365,6 +534,10 @@ namespace cxsom {
 	    file.put(char(0));
 	  file.seekp(0, std::ios_base::beg);
 	  file << type->name() << '\n' << std::flush;
+
+	  this->layout = layout;
+	  file.seekp(cxsom_OFFSET_LAYOUT_IN_FILE, std::ios_base::beg);
+	  file.put(static_cast<char>(layout));
 	  
 	  file.seekp(cxsom_OFFSET_CACHE_SIZE_IN_FILE, std::ios_base::beg);
 	  
@@ -379,6 +552,9 @@ namespace cxsom {
 
 	  next_free_pos = 0;
 	  write_uint(next_free_pos);
+
+	  if(layout == Layout::Aligned)
+	    for(std::size_t p = cxsom_OFFSET_HEADER_IN_FILE; p < cxsom_OFFSET_ALIGNED_HEADER_IN_FILE; ++p) file.put(char(0));
 	  file.close();
 #ifdef cxsomDEBUG_VARFILE
 	  std::cout << "[varfile " << var_path << "] Realize from scratch : "
@@ -389,20 +565,60 @@ namespace cxsom {
 #endif
 	}
 	
+	this->kept_opened = kept_opened;
 	if(kept_opened) {
+	  FilePool::get().forget(*this);
 	  if(!file.is_open()) {
 	    file.clear();
 	    file.open(var_path.c_str());
 	  }
 	}
-	else if(file.is_open())
-	  file.close(); 
+	else
+	  FilePool::get().close_unpooled(*this);
 	
-	data_size = sizeof(bool) + this->type->byte_length();
+	if(this->layout == Layout::Packed) {
+	  data_offset    = cxsom_OFFSET_HEADER_IN_FILE;
+	  ready_offset   = 0;
+	  payload_offset = sizeof(bool);
+	  data_size      = sizeof(bool) + this->type->byte_length();
+	}
+	else {
+	  data_offset    = cxsom_OFFSET_ALIGNED_HEADER_IN_FILE;
+	  ready_offset   = this->type->byte_length();
+	  payload_offset = 0;
+	  data_size      = ((ready_offset + sizeof(bool) + cxsom_SLOT_ALIGNMENT - 1) / cxsom_SLOT_ALIGNMENT) * cxsom_SLOT_ALIGNMENT;
+	}
 	  
 	realized = true;
       }
 
+      /**
+       * The variable is handled in memory only, no file is created
+       * and no header is written. Such variables have no history
+       * (their file size is 0), only their highest time is tracked.
+       */
+      void realize_in_memory(type::ref type, std::size_t cache_size) {
+	if(!type) {
+	  std::ostringstream msg;
+	  msg << "cxsom::data::File::realize_in_memory: " << var_symb << " requires a type.";
+	  throw error::file(msg.str());
+	}
+	this->type    = type;
+	layout        = default_layout;
+	this->cache_size = cache_size;
+	file_size     = 0;
+	highest_time  = no_time();
+	next_free_pos = 0;
+	in_memory     = true;
+	realized      = true;
+#ifdef cxsomDEBUG_VARFILE
+	std::cout << "[varfile " << var_path << "] Realize in memory : "
+		  << "cache_size=" << this->cache_size << std::endl;
+#endif
+      }
+
+      bool is_in_memory() const {return in_memory;}
+
       /**
        * Returns data instance availability before the writing. If the instance is in the buffer (i.e. not forgotten), it is ready after writing.
        */
@@ -418,10 +634,11 @@ namespace cxsom {
 
 	if(file_size == 0) {
 	  if(highest_time == no_time() || at > highest_time) {
-	    WithFile with_file(file, var_path);
 	    highest_time = at;
-	    file.seekp(cxsom_OFFSET_HIGHEST_TIME_IN_FILE, std::ios_base::beg);  write_uint(highest_time);
-	    file << std::flush;
+	    if(!in_memory) {
+	      WithFile with_file(*this);
+	      write_header();
+	    }
 #ifdef cxsomDEBUG_VARFILE
 	    std::cout << "[varfile " << var_path << "]@" << at << "    forgotten since file_size=0, highest time updated to " << highest_time << '.' << std::endl;
 #endif
@@ -438,8 +655,8 @@ namespace cxsom {
 	if(highest_time == no_time()) {
 	  // This is the first time something is written in the buffer.
     
-	  WithFile with_file(file, var_path);
-	  file.seekp(cxsom_OFFSET_HEADER_IN_FILE, std::ios_base::beg);
+	  WithFile with_file(*this);
+	  file.seekp(data_offset, std::ios_base::beg);
 
 	  if(at >= file_size) {
 	    // We have to allocate the full buffer length.
@@ -447,7 +664,7 @@ namespace cxsom {
 	    for(std::size_t p = 0; p < nb_bytes; ++p) 
 	      file.put(0);
 	    
-	    file.seekp(cxsom_OFFSET_HEADER_IN_FILE, std::ios_base::beg); // We go back to 0
+	    file.seekp(data_offset, std::ios_base::beg); // We go back to 0
 	    next_free_pos = next_pos(0, file_size);
 	  }
 	  else {
@@ -460,26 +677,15 @@ namespace cxsom {
 	    next_free_pos = next_pos(at, file_size);
 	  }
 
-	  auto slot_pos = file.tellp();
-	    
-	  // We write the content before marking it as ready, so that
-	  // file readers cannot consider a file chunk readable while
-	  // it is currently beeing filled.
-	  file.put(static_cast<char>(Availability::Busy));
-	  d->write(file);
-	  file << std::flush;
+	  std::size_t slot_pos = file.tellp();
+	  write_slot(slot_pos, d);
 	  
 #ifdef cxsomDEBUG_VARFILE
-	  auto end_write_pos = file.tellp();
+	  auto end_write_pos = slot_pos + data_size;
 #endif
-	    
-	  file.seekp(slot_pos, std::ios_base::beg);
-	  file.put(static_cast<char>(Availability::Ready));
 
 	  highest_time = at;
-	  file.seekp(cxsom_OFFSET_HIGHEST_TIME_IN_FILE, std::ios_base::beg);  write_uint(highest_time);
-	  file.seekp(cxsom_OFFSET_NEXT_FREE_POS_IN_FILE, std::ios_base::beg); write_uint(next_free_pos);
-	  file << std::flush;
+	  write_header();
 	  
 #ifdef cxsomDEBUG_VARFILE
 	  std::cout << "[varfile " << var_path << "]@" << at << "    was busy (written to an empty file): " 
@@ -497,9 +703,9 @@ namespace cxsom {
 	  // We write in the past
 	  std::size_t highest_time_minus_at = highest_time - at;
 	  if(is_past_in_buffer(highest_time_minus_at, file_size)) {
-	    WithFile with_file(file, var_path);
-	    seekg_htma(highest_time_minus_at);
-	    std::size_t file_pos = file.tellp();
+	    WithFile with_file(*this);
+	    std::size_t file_pos = slot_pos_htma(highest_time_minus_at);
+	    file.seekg(file_pos + ready_offset, std::ios_base::beg);
 	    if(file.get() != 0) {
 #ifdef cxsomDEBUG_VARFILE
 	      std::cout << "[varfile " << var_path << "]@" << at << "    was ready (no write here) : " 
@@ -511,20 +717,11 @@ namespace cxsom {
 	      return FileAvailability::Ready;
 	    }
 	    
-	    // We write the content before marking it as ready, so that
-	    // file readers cannot consider a file chunk readable while
-	    // it is currently beeing filled.
-	    file.seekp(file_pos + std::streamoff(1), std::ios_base::beg); 
-	    d->write(file);
+	    write_slot(file_pos, d);
 	    file << std::flush;
-	  
 #ifdef cxsomDEBUG_VARFILE
-	    auto end_write_pos = file.tellp();
+	    auto end_write_pos = file_pos + data_size;
 #endif
-	    
-	    file.seekp(file_pos, std::ios_base::beg);
-	    file.put(static_cast<char>(Availability::Ready));
-	    file << std::flush;
 #ifdef cxsomDEBUG_VARFILE
 	    std::cout << "[varfile " << var_path << "]    was busy (written in the past) : " 
 		      << "cache_size=" << this->cache_size << ", "
@@ -551,7 +748,7 @@ namespace cxsom {
 	//
 	///////////////
 
-	WithFile with_file(file, var_path);
+	WithFile with_file(*this);
 
 	// We have to clear the values in the buffer from
 	// the last one until at-1.
@@ -569,10 +766,10 @@ namespace cxsom {
 
 	  // We have to clear the whole buffer.
 	  std::size_t nb_bytes = file_size * data_size;
-	  file.seekp(cxsom_OFFSET_HEADER_IN_FILE, std::ios_base::beg);
+	  file.seekp(data_offset, std::ios_base::beg);
 	  for(std::size_t p = 0; p < nb_bytes; ++p) file.put(0);
 	  
-	  file.seekp(cxsom_OFFSET_HEADER_IN_FILE, std::ios_base::beg); // We go back to 0
+	  file.seekp(data_offset, std::ios_base::beg); // We go back to 0
 	  next_free_pos = next_pos(0, file_size);
 	}
 	else {
@@ -583,7 +780,7 @@ namespace cxsom {
 	  std::size_t upper_bound   = std::min(file_size, data_pos);
 	  std::size_t nb_to_the_end = upper_bound - next_free_pos;
 	  std::size_t nb_bytes      = nb_to_the_end * data_size;
-	  file.seekp(cxsom_OFFSET_HEADER_IN_FILE + next_free_pos * data_size, std::ios_base::beg);
+	  file.seekp(data_offset + next_free_pos * data_size, std::ios_base::beg);
 #ifdef cxsomDEBUG_VARFILE
 	  std::cout << "[varfile " << var_path << "]    Nota : clear " << nb_bytes
 		    << " bytes first from " << file.tellp() << std::endl;
@@ -595,7 +792,7 @@ namespace cxsom {
 	  
 	  if(data_pos >= file_size) {
 	    data_pos -= file_size;
-	    file.seekp(cxsom_OFFSET_HEADER_IN_FILE, std::ios_base::beg); // We go back to 0
+	    file.seekp(data_offset, std::ios_base::beg); // We go back to 0
 	    // we have to write data_pos zeroes.
 	    std::size_t nb_bytes = data_pos * data_size;
 #ifdef cxsomDEBUG_VARFILE
@@ -609,27 +806,15 @@ namespace cxsom {
 	  next_free_pos = next_pos(data_pos, file_size);
 	}
 
-	auto slot_pos = file.tellp();
-
-	    
-	// We write the content before marking it as ready, so that
-	// file readers cannot consider a file chunk readable while
-	// it is currently beeing filled.
-	file.put(static_cast<char>(Availability::Busy));
-	d->write(file);
-	file << std::flush;
+	std::size_t slot_pos = file.tellp();
+	write_slot(slot_pos, d);
 	
 #ifdef cxsomDEBUG_VARFILE
-	auto end_write_pos = file.tellp();
+	auto end_write_pos = slot_pos + data_size;
 #endif
 	    
-	file.seekp(slot_pos, std::ios_base::beg);
-	file.put(static_cast<char>(Availability::Ready));
-	    
 	highest_time  = at;
-	file.seekp(cxsom_OFFSET_HIGHEST_TIME_IN_FILE, std::ios_base::beg);  write_uint(highest_time);
-	file.seekp(cxsom_OFFSET_NEXT_FREE_POS_IN_FILE, std::ios_base::beg); write_uint(next_free_pos);
-	file << std::flush;
+	write_header();
 	
 #ifdef cxsomDEBUG_VARFILE
 	std::cout << "[varfile " << var_path << "]@" << at << "    was busy (written in the future) : " 
@@ -643,7 +828,34 @@ namespace cxsom {
       }
 
       /**
-       * Returns data instance availability of the data. d is set only in case of availability being 'Ready'.
+       * This writes a range of (at, data) pairs with a single file
+       * opening and a single header update at the end. Sort the
+       * range by increasing times, so that slot clearings are done
+       * once.
+       */
+      template<typename It>
+      void write(It begin, It end) {
+	if(begin == end) return;
+	if(in_memory) {
+	  for(auto it = begin; it != end; ++it) write(it->first, it->second);
+	  return;
+	}
+	WithFile with_file(*this);
+	header_deferred = true;
+	try {
+	  for(auto it = begin; it != end; ++it) write(it->first, it->second);
+	}
+	catch(...) {
+	  header_deferred = false;
+	  write_header();
+	  throw;
+	}
+	header_deferred = false;
+	write_header();
+      }
+      
+      /**
+       * Returns data instance availability of the data. d is set only in case of availability being 'Ready'. If d is nullptr, only the ready byte is read.
        */
       FileAvailability read(std::size_t at, data::ref d) {
 #ifdef cxsomDEBUG_VARFILE
@@ -686,15 +898,19 @@ namespace cxsom {
 	// We read from the past
 	std::size_t highest_time_minus_at = highest_time - at;
 	if(is_past_in_buffer(highest_time_minus_at, file_size)) {
-	  WithFile with_file(file, var_path);
-	  seekg_htma(highest_time_minus_at);
+	  WithFile with_file(*this);
+	  auto slot_pos = slot_pos_htma(highest_time_minus_at);
+	  file.seekg(slot_pos + ready_offset, std::ios_base::beg);
 	  if(file.get() == 0) {
 #ifdef cxsomDEBUG_VARFILE
 	    std::cout << "is busy (in file but not initialized)." << std::endl;
 #endif
 	    return FileAvailability::Busy;
 	  }
-	  d->read(file);
+	  if(d) {
+	    if(layout != Layout::Packed) file.seekg(slot_pos + payload_offset, std::ios_base::beg);
+	    d->read(file);
+	  }
 #ifdef cxsomDEBUG_VARFILE
 	  std::cout << "is ready (in file, already set)." << std::endl;
 #endif
@@ -708,6 +924,13 @@ namespace cxsom {
 	}
       }
 
+      /**
+       * Returns data instance availability without reading the payload.
+       */
+      FileAvailability probe(std::size_t at) {
+	return read(at, nullptr);
+      }
+
       /**
        * This update memory info (highest_time, next_free_pos, ...)
        * from the file. This is used if the file has been modified by
@@ -719,8 +942,10 @@ namespace cxsom {
 #endif
 	if(!realized)
 	  throw error::file("Syncing unrealized file.");
+	if(in_memory)
+	  return;
 	
-	WithFile with_file(file, var_path);
+	WithFile with_file(*this);
 	// Getting cache_size
 	file.seekg(cxsom_OFFSET_CACHE_SIZE_IN_FILE, std::ios_base::beg);
 	read_uint(this->cache_size);
@@ -779,7 +1004,7 @@ namespace cxsom {
 
 	
 	os << "\e[90m"; // Dark gray
-	WithFile with_file(file, var_path);
+	WithFile with_file(*this);
 	if(file_size > 0 && inf != no_time()) {
 	  if(sup - inf + 1 > cxsom_MAX_CONTENT_SIZE) {
 	    os << "...";
@@ -801,12 +1026,135 @@ namespace cxsom {
 
     };
 
+    inline void FilePool::evict() {
+      for(auto it = files.end(); files.size() > capacity && it != files.begin();) {
+	auto& f = **(--it);
+	if(f.nb_users == 0) {
+	  f.file.close();
+	  f.pooled = false;
+	  it = files.erase(it);
+	}
+      }
+    }
+    
+    inline void FilePool::acquire(File& f) {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++f.nb_users;
+      if(f.pooled)
+	files.splice(files.begin(), files, f.in_pool);
+      else {
+	if(!f.file.is_open()) {
+	  f.file.clear();
+	  try {
+	    f.file.open(f.var_path.c_str(), std::ios::out | std::ios::in);
+	  }
+	  catch(...) {
+	    --f.nb_users;
+	    throw;
+	  }
+	}
+	f.in_pool = files.insert(files.begin(), &f);
+	f.pooled  = true;
+	evict();
+      }
+    }
+    
+    inline void FilePool::release(File& f) {
+      std::lock_guard<std::mutex> lock(mutex);
+      --f.nb_users;
+      if(files.size() > capacity) evict();
+    }
+    
+    inline void FilePool::forget(File& f) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(f.pooled) {
+	files.erase(f.in_pool);
+	f.pooled = false;
+      }
+    }
 
-
+    inline void FilePool::close_unpooled(File& f) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(!f.pooled && f.file.is_open())
+	f.file.close();
+    }
 
     
     class Variable;
 
+    /**
+     * This queues the instances declared ready, so that dedicated I/O
+     * threads write them into their files, rather than the thread
+     * that has computed them. Each I/O thread takes all the queued
+     * instances at once and writes them variable by variable, with a
+     * single header update per variable. The queue is bounded: pushing
+     * blocks while it is full.
+     */
+    class WriteBehind {
+    private:
+      struct Job {
+	Variable* var;
+	std::size_t at;
+	data::ref d;
+      };
+      
+      std::mutex mutex;
+      std::condition_variable not_empty;
+      std::condition_variable not_full;
+      std::condition_variable idle;
+      std::deque<Job> jobs;
+      std::size_t capacity;
+      std::size_t nb_writing = 0;
+      bool stopping = false;
+      std::vector<std::thread> io_threads;
+
+      void io_thread();
+      
+    public:
+      WriteBehind()                              = delete;
+      WriteBehind(const WriteBehind&)            = delete;
+      WriteBehind& operator=(const WriteBehind&) = delete;
+
+      /**
+       * @param nb_threads The number of I/O threads.
+       * @param capacity The maximal number of queued instances.
+       */
+      WriteBehind(std::size_t nb_threads, std::size_t capacity)
+	: capacity(std::max(capacity, std::size_t(1))) {
+	for(std::size_t i = 0; i < std::max(nb_threads, std::size_t(1)); ++i)
+	  io_threads.emplace_back([this](){io_thread();});
+      }
+
+      /**
+       * The pending instances are written before the I/O threads terminate.
+       */
+      ~WriteBehind() {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  stopping = true;
+	}
+	not_empty.notify_all();
+	for(auto& t : io_threads) t.join();
+      }
+
+      void push(Variable* var, std::size_t at, data::ref d) {
+	{
+	  std::unique_lock<std::mutex> lock(mutex);
+	  not_full.wait(lock, [this](){return jobs.size() < capacity;});
+	  jobs.push_back({var, at, d});
+	}
+	not_empty.notify_one();
+      }
+
+      /**
+       * Waits until all the queued instances are written.
+       */
+      void flush() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this](){return jobs.empty() && nb_writing == 0;});
+      }
+    };
+
     /**
      * An instance is a variable, in a timeline, at a time step. It
      * can be read simultaneously by many readers, while writing into
@@ -827,15 +1175,21 @@ namespace cxsom {
       mutable std::mutex                write_mutex;
       mutable std::condition_variable   no_writing_in_progress;
       
-      Availability status      = Availability::Busy;
+      mutable std::atomic<Availability> status = Availability::Busy; // Loading (under the variable mutex) may find out that the instance is not ready anymore.
       std::size_t at           = 0;
       std::size_t datation     = 0;
-      ref          content     = nullptr;
       Variable*    owner       = nullptr;
 
+      // The payload is allocated and read from the file at the first
+      // access to the data, so that checking the status of an
+      // instance does not read its content.
+      mutable ref               content = nullptr;
+      mutable std::atomic<bool> loaded  = false;
+
       friend class Variable;
 
-      Instance(Availability status, std::size_t at, data::ref content, Variable* owner);
+      Instance(Availability status, std::size_t at, Variable* owner);
+      void load() const;
       Instance()                           = default;
       Instance(const Instance&)            = default;
       Instance& operator=(const Instance&) = default;
@@ -849,6 +1203,11 @@ namespace cxsom {
 
       template<typename READING_FUNC>
       void get(const READING_FUNC& read) const;
+
+      /**
+       * This reads the status only, the payload is not loaded.
+       */
+      Availability get_status() const;
       
       template<typename WRITING_FUNC>
       void set(const WRITING_FUNC& write);
@@ -862,13 +1221,27 @@ namespace cxsom {
     private:
 
       friend class Instance;
+      friend class WriteBehind;
       File file;
       std::mutex mutex;
+      WriteBehind* write_behind;
+
+      // These are the instances declared ready that are not written
+      // in the file yet, when a write-behind queue is used.
+      std::map<std::size_t, data::ref> pending;
+
+      // The payload of the copy comes from the PayloadPool, it goes
+      // back to it once the copy is written.
+      static data::ref copy_of(data::ref d) {
+	return data::copy(*d);
+      }
       
       // This enables to retreive the instances if they have already
       // been extracted from the file, without reading the file (i.e. a
       // kind of cache).
       std::map<std::size_t, instance_ref> cached_instances;
+
+      stats::Variable counters;
       
 
       // Tries to remove the nb oldest unused instance in the
@@ -891,6 +1264,7 @@ namespace cxsom {
       
       instance_ref instance(std::size_t at) {
 	if(auto iter = cached_instances.find(at); iter != cached_instances.end()) {
+	  stats::add(counters.hits, 1);
 #ifdef cxsomDEBUG_VARIABLE
 	std::cout << "[var " << (symbol::Variable)file << "] retrieveing cached instance @" << at
 		  << " (availability = " << iter->second->status << ")." << std::endl;
@@ -898,11 +1272,16 @@ namespace cxsom {
 	  return iter->second;
 	}
 	
-	// If we have not returned, we have to build the instance.
+	// If we have not returned, we have to build the instance. Only
+	// its status is read here.
+	stats::add(counters.misses, 1);
 	
-	auto d         = data::make(file.get_type());
-	Availability s = availability_of(file.read(at, d));
-	auto res = std::shared_ptr<Instance>(new Instance(s, at, d, this));
+	Availability s;
+	if(pending.find(at) != pending.end())
+	  s = Availability::Ready;
+	else
+	  s = availability_of(file.probe(at));
+	auto res = std::shared_ptr<Instance>(new Instance(s, at, this));
 	std::size_t bound = std::max(file.get_cache_size(), std::size_t(1));
 	auto next_size = cached_instances.size() + 1;
 	if(next_size > bound) remove_oldest(next_size - bound);
@@ -913,10 +1292,78 @@ namespace cxsom {
 	return res;  
       }
 
-       Availability sync(std::size_t at, data::ref d) {
+      // The mutex is supposed to be held.
+      void load_unlocked(const Instance& i) {
+	if(i.loaded) return;
+	if(auto it = pending.find(i.at); it != pending.end())
+	  i.content = copy_of(it->second);
+	else {
+	  i.content = data::make(file.get_type());
+	  if(i.status == Availability::Ready) {
+	    trace::Span span(trace::Event::FileRead);
+	    if(span) {
+	      symbol::Variable v = file;
+	      span->label(v.timeline, v.name, i.at);
+	      span->count = 1;
+	    }
+	    // The slot may have been overwritten or cleared by somebody
+	    // else since the status was read. The instance is Busy
+	    // then, until it is synchronized again. A forgotten slot
+	    // stays Ready, as when it is probed.
+	    if(file.read(i.at, i.content) == FileAvailability::Busy)
+	      i.status = Availability::Busy;
+	    else if(!file.is_in_memory())
+	      stats::add(counters.bytes_read, file.get_type()->byte_length());
+	  }
+	}
+	i.loaded = true;
+#ifdef cxsomDEBUG_VARIABLE
+	std::cout << "[var " << (symbol::Variable)file << "] @" << i.at << ": payload loaded." << std::endl;
+#endif
+      }
+
+      void load(const Instance& i) {
+	std::lock_guard<std::mutex> lock(mutex);
+	load_unlocked(i);
+      }
+
+      // Writing at time at may forget the slots up to at - file_size
+      // in the file. The cached instances of these times need their
+      // payload to be loaded before. The mutex is supposed to be held.
+      void load_before_overwrite(std::size_t at) {
+	auto file_size = file.get_file_size();
+	if(file_size == 0 || at < file_size) return;
+	for(auto it = cached_instances.begin(); it != cached_instances.end() && it->first <= at - file_size; ++it)
+	  load_unlocked(*(it->second));
+      }
+
+      Availability probe(std::size_t at) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(pending.find(at) != pending.end())
+	  return Availability::Ready;
+	file.sync();
+	auto res = file.probe(at);
+#ifdef cxsomDEBUG_VARIABLE
+	std::cout << "[var " << (symbol::Variable)file << "] @" << at << ": sync (probe) : got " << res << '.' << std::endl;
+#endif
+	return (Availability)res;
+      }
+
+      Availability sync(std::size_t at, data::ref d) {
 	std::lock_guard<std::mutex> lock(mutex);
+	if(auto it = pending.find(at); it != pending.end()) {
+	  it->second->write(d->first_byte());
+	  return Availability::Ready;
+	}
+	trace::Span span(trace::Event::FileRead);
+	if(span) {
+	  symbol::Variable v = file;
+	  span->label(v.timeline, v.name, at);
+	  span->count = 1;
+	}
 	file.sync();
 	auto res = file.read(at, d);
+	if(res == FileAvailability::Ready && !file.is_in_memory()) stats::add(counters.bytes_read, d->type->byte_length());
 #ifdef cxsomDEBUG_VARIABLE
 	std::cout << "[var " << (symbol::Variable)file << "] @" << at << ": sync (read) : got " << res << '.' << std::endl;
 #endif
@@ -925,12 +1372,62 @@ namespace cxsom {
 
       
       void declare_ready(std::size_t at, data::ref d) {
+	if(subscribe::nb_subscribers > 0) subscribe::Hub::get().ready(file, at, *d);
+	if(write_behind && !file.is_in_memory()) {
+	  auto copy = copy_of(d);
+	  {
+	    std::lock_guard<std::mutex> lock(mutex);
+	    pending[at] = copy;
+	  }
+	  // This may block if the queue is full, so the mutex is not held.
+	  write_behind->push(this, at, copy);
+#ifdef cxsomDEBUG_VARIABLE
+	  std::cout << "[var " << (symbol::Variable)file << "] @" << at << ": declare ready (queued)." << std::endl;
+#endif
+	  return;
+	}
 	std::lock_guard<std::mutex> lock(mutex);
+	trace::Span span(trace::Event::FileWrite);
+	if(span) {
+	  symbol::Variable v = file;
+	  span->label(v.timeline, v.name, at);
+	  span->count = 1;
+	}
+	load_before_overwrite(at);
 	file.write(at, d);
+	if(!file.is_in_memory()) stats::add(counters.bytes_written, d->type->byte_length());
 #ifdef cxsomDEBUG_VARIABLE
 	std::cout << "[var " << (symbol::Variable)file << "] @" << at << ": declare ready (write)." << std::endl;
 #endif
       }
+
+      // This is called by the I/O threads, the range is sorted by increasing times.
+      template<typename It>
+      void persist(It begin, It end) {
+	std::lock_guard<std::mutex> lock(mutex);
+	trace::Span span(trace::Event::FileWrite);
+	if(span && begin != end) {
+	  symbol::Variable v = file;
+	  span->label(v.timeline, v.name, begin->first);
+	  span->count = std::distance(begin, end);
+	}
+	try {
+	  if(begin != end) load_before_overwrite(std::prev(end)->first);
+	  file.write(begin, end);
+	  stats::add(counters.bytes_written, std::distance(begin, end) * file.get_type()->byte_length());
+	}
+	catch(std::exception& e) {
+	  // Failed instances stay pending, so they remain readable from memory.
+	  std::cerr << "cxsom::data::Variable::persist(" << (symbol::Variable)file << ") : " << e.what() << std::endl;
+	  return;
+	}
+	for(auto it = begin; it != end; ++it)
+	  if(auto p = pending.find(it->first); p != pending.end() && p->second == it->second)
+	    pending.erase(p);
+#ifdef cxsomDEBUG_VARIABLE
+	std::cout << "[var " << (symbol::Variable)file << "] " << std::distance(begin, end) << " queued instances written." << std::endl;
+#endif
+      }
       
     public:
       Variable()                           = delete;
@@ -939,14 +1436,23 @@ namespace cxsom {
       Variable& operator=(const Variable&) = delete;
       Variable& operator=(Variable&&)      = delete;
 
+      /**
+       * @param write_behind If not nullptr, ready instances are written by this queue rather than synchronously.
+       * @param in_memory If true, the variable has no file (see File::realize_in_memory), file_size and kept_opened are ignored.
+       */
       Variable(const fs::path& root_path,
 	       const symbol::Variable& var_symb,
 	       type::ref type,
 	       std::optional<std::size_t> cache_size,
 	       std::optional<std::size_t> file_size,
-	       bool kept_opened)
-	: file(root_path, var_symb), mutex(), cached_instances() {
-	file.realize(type, cache_size, file_size, kept_opened);
+	       bool kept_opened,
+	       WriteBehind* write_behind = nullptr,
+	       bool in_memory = false)
+	: file(root_path, var_symb), mutex(), write_behind(write_behind), pending(), cached_instances() {
+	if(in_memory)
+	  file.realize_in_memory(type, cache_size.value_or(1));
+	else
+	  file.realize(type, cache_size, file_size, kept_opened);
 #ifdef cxsomDEBUG_VARIABLE
 	std::cout << "[var " << (symbol::Variable)file << "] created." << std::endl;
 #endif
@@ -955,6 +1461,8 @@ namespace cxsom {
       std::size_t history_length() {
 	std::lock_guard<std::mutex> lock(mutex);
 	file.sync();
+	if(!pending.empty())
+	  return std::max(file.get_next_time(), pending.rbegin()->first + 1);
 	return file.get_next_time();
       }
 
@@ -971,15 +1479,70 @@ namespace cxsom {
 	return instance(at);
       }
 
+      /**
+       * The file may have been written by someone else. This re-reads
+       * the cached instances in [from_at, to_at] that are known as
+       * busy, and returns the times of the ones that are ready now.
+       */
+      std::vector<std::size_t> sync_busy(std::size_t from_at, std::size_t to_at) {
+	std::vector<instance_ref> busy;
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  if(file.is_in_memory()) return {};
+	  for(auto it = cached_instances.lower_bound(from_at); it != cached_instances.end() && it->first <= to_at; ++it)
+	    if(it->second->status == Availability::Busy) busy.push_back(it->second);
+	}
+	std::vector<std::size_t> res;
+	for(auto& i : busy)
+	  i->sync([&res, &i](auto status) {if(status == Availability::Ready) res.push_back(i->at);});
+	return res;
+      }
+
       auto get_type() const {return file.get_type();}
+      auto get_file_size() const {return file.get_file_size();}
+      auto get_cache_size() const {return file.get_cache_size();}
+      auto get_layout() const {return file.get_layout();}
+      auto is_in_memory() const {return file.is_in_memory();}
+      const stats::Variable& get_stats() const {return counters;}
       
     };
 
     
 
+    inline void WriteBehind::io_thread() {
+      while(true) {
+	std::vector<Job> batch;
+	{
+	  std::unique_lock<std::mutex> lock(mutex);
+	  not_empty.wait(lock, [this](){return stopping || !jobs.empty();});
+	  if(jobs.empty()) return;
+	  batch.assign(std::make_move_iterator(jobs.begin()), std::make_move_iterator(jobs.end()));
+	  jobs.clear();
+	  ++nb_writing;
+	}
+	not_full.notify_all();
+
+	std::sort(batch.begin(), batch.end(),
+		  [](const Job& a, const Job& b) {return std::make_pair(a.var, a.at) < std::make_pair(b.var, b.at);});
+	std::vector<std::pair<std::size_t, data::ref>> slots;
+	for(auto begin = batch.begin(); begin != batch.end();) {
+	  auto end = begin;
+	  slots.clear();
+	  for(; end != batch.end() && end->var == begin->var; ++end) slots.emplace_back(end->at, end->d);
+	  begin->var->persist(slots.begin(), slots.end());
+	  begin = end;
+	}
+
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  --nb_writing;
+	  if(jobs.empty() && nb_writing == 0) idle.notify_all();
+	}
+      }
+    }
       
-    inline Instance::Instance(Availability status, std::size_t at, data::ref content, Variable* owner)
-      : status(status), at(at), datation(0), content(content), owner(owner) {
+    inline Instance::Instance(Availability status, std::size_t at, Variable* owner)
+      : status(status), at(at), datation(0), owner(owner) {
 #ifdef cxsomDEBUG_VARIABLE
       std::cout << "[instance " << (symbol::Variable)(owner->file) << "]@" << at << " (" << this << ") : created with status " << status << std::endl;
 #endif
@@ -1001,8 +1564,11 @@ namespace cxsom {
       }
 
   
-      status = owner->sync(at, content);
-      sync(status);
+      Availability s;
+      if(loaded) s = owner->sync(at, content);
+      else       s = owner->probe(at);
+      status = s;
+      sync(s);
 	
       {
 	std::unique_lock<std::mutex> lock(read_mutex);
@@ -1022,7 +1588,9 @@ namespace cxsom {
 #ifdef cxsomDEBUG_VARIABLE
       std::cout << "[instance " << (symbol::Variable)(owner->file) << "]@" << at << " (" << this << ") get >>> status was " << status << std::endl;
 #endif
-      const auto& d = *content; read(status, datation, d);
+      load();
+      Availability s = status;
+      const auto& d = *content; read(s, datation, d);
 #ifdef cxsomDEBUG_VARIABLE
       std::cout << "[instance " << (symbol::Variable)(owner->file) << "]@" << at << " (" << this << ") get <<< status is  " << status << std::endl;
 #endif	
@@ -1032,6 +1600,24 @@ namespace cxsom {
       }
     }
     
+    inline void Instance::load() const {
+      if(!loaded) owner->load(*this);
+    }
+
+    inline Availability Instance::get_status() const {
+      {
+	std::unique_lock<std::mutex> lock(write_mutex);
+	while(writing) no_writing_in_progress.wait(lock);
+	++nb_readers;
+      }
+      Availability res = status;
+      {
+	std::unique_lock<std::mutex> lock(read_mutex);
+	if(--nb_readers == 0) nobody_reads.notify_all();
+      }
+      return res;
+    }
+    
     template<typename WRITING_FUNC>
     void Instance::set(const WRITING_FUNC& write) {
       writing = true;
@@ -1043,9 +1629,12 @@ namespace cxsom {
 #ifdef cxsomDEBUG_VARIABLE
       std::cout << "[instance " << (symbol::Variable)(owner->file) << "]@" << at << " (" << this << ") set >>> status was " << status << std::endl;
 #endif
-      auto prev_status = status;
-      auto& d = *content; write(status, datation, d);
-      if(prev_status == Availability::Busy && status == Availability::Ready) {
+      load();
+      Availability prev_status = status;
+      Availability s = prev_status;
+      auto& d = *content; write(s, datation, d);
+      status = s;
+      if(prev_status == Availability::Busy && s == Availability::Ready) {
 #ifdef cxsomDEBUG_VARIABLE
 	std::cout << "[instance " << (symbol::Variable)(owner->file) << "]@" << at << " (" << this << ") set : data setting says 'ready'." << std::endl;
 #endif
@@ -1066,44 +1655,258 @@ namespace cxsom {
       }
     }     
     
-    class Center {
+    /**
+     * This calls f(i) for i in [0, n), the calls being spread over
+     * nb_threads threads.
+     */
+    template<typename F>
+    void parallel_for(std::size_t n, std::size_t nb_threads, const F& f) {
+      nb_threads = std::max(std::size_t(1), std::min(nb_threads, n));
+      std::vector<std::thread> threads;
+      for(std::size_t t = 0; t < nb_threads; ++t)
+	threads.emplace_back([n, nb_threads, t, &f]() {for(std::size_t i = t; i < n; i += nb_threads) f(i);});
+      for(auto& thread : threads) thread.join();
+    }
+
+    /**
+     * The manifest records the variables of a root directory with
+     * their type and geometry, in the file root_dir/cxsom.manifest,
+     * so that they are known without opening all the variable
+     * files. It also records the modification times of the
+     * directories, which tells whether some variable files have been
+     * added or removed since by someone else. In this case, the
+     * manifest is stale, and it is rebuilt from a parallel scan of
+     * the variable files.
+     *
+     * The file is a list of tab-separated lines, appended when new
+     * variables are created. The last line about a directory holds.
+     */
+    class Manifest {
+    public:
+      
+      struct Entry {
+	std::string type;
+	Layout      layout;
+	std::size_t cache_size;
+	std::size_t file_size;
+      };
+
+      static constexpr const char* filename = "cxsom.manifest";
+      
     private:
-      std::mutex mutex;
+      
       fs::path root_dir;
-      std::map<symbol::Variable, Variable> variables; 
+      fs::path path;
+      std::mutex mutex;
+      std::map<symbol::Variable, Entry>          entries;
+      std::map<std::string, fs::file_time_type> dirs; // Relative path (. for root_dir) -> modification time.
 
-      fs::path var_path(const symbol::Variable& var_symb) {
-	return root_dir / var_symb.timeline / (var_symb.name + ".var");
+      static std::string relative(const fs::path& root_dir, const fs::path& p) {
+	return fs::relative(p, root_dir).string();
       }
       
-      void touch_var(const symbol::Variable& var_symb) {
-	if(auto it = variables.find(var_symb); it == variables.end()) {
-	  auto p = var_path(var_symb);
-	  if(!fs::exists(p))  {
-	    std::ostringstream ostr;
-	    ostr << "cxsom::data::Center::touch_var(" << var_symb << "): variable doesn't exist yet.";
-	    throw error::unknown_variable(ostr.str());
-	  }
-	  variables.try_emplace(var_symb,
-				root_dir, var_symb,
-				nullptr, std::nullopt, std::nullopt, false);
-	}
+      static void write_var(std::ostream& os, const symbol::Variable& var, const Entry& e) {
+	os << "var\t" << var.timeline << '\t' << var.name << '\t' << e.type << '\t'
+	   << static_cast<int>(e.layout) << '\t' << e.cache_size << '\t' << e.file_size << '\n';
+      }
+      
+      static void write_dir(std::ostream& os, const std::string& dir, fs::file_time_type t) {
+	os << "dir\t" << t.time_since_epoch().count() << '\t' << dir << '\n';
       }
 
-      Variable& get_var(const symbol::Variable& var_symb) {
-	if(auto it = variables.find(var_symb); it == variables.end()) {
-	  auto p = var_path(var_symb);
-	  if(!fs::exists(p))  {
-	    std::ostringstream ostr;
-	    ostr << "cxsom::data::Center::get_var(" << var_symb << "): variable doesn't exist yet.";
-	    throw error::unknown_variable(ostr.str());
+      // This calls f on the relative paths of the directories from the one of var up to root_dir.
+      template<typename F>
+      void for_each_dir_of(const symbol::Variable& var, const F& f) {
+	auto d = (root_dir / var.timeline / (var.name + ".var")).parent_path();
+	for(auto rel = fs::relative(d, root_dir); !rel.empty() && rel != "."; rel = rel.parent_path()) f(rel.string());
+	f(std::string("."));
+      }
+      
+    public:
+
+      Manifest(const fs::path& root_dir) : root_dir(root_dir), path(root_dir / filename) {}
+      Manifest()                           = delete;
+      Manifest(const Manifest&)            = delete;
+      Manifest& operator=(const Manifest&) = delete;
+
+      const std::map<symbol::Variable, Entry>& variables() const {return entries;}
+
+      std::optional<Entry> find(const symbol::Variable& var) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(auto it = entries.find(var); it != entries.end()) return it->second;
+	return std::nullopt;
+      }
+      
+      /**
+       * This reads the manifest file.
+       * @returns true if the manifest file exists and is not stale.
+       */
+      bool load() {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	dirs.clear();
+	std::ifstream file(path);
+	if(!file) return false;
+	
+	std::string line, kind, timeline, name, type, layout, cache_size, file_size, time, dir;
+	while(std::getline(file, line)) {
+	  std::istringstream is(line);
+	  std::getline(is, kind, '\t');
+	  if(kind == "var") {
+	    std::getline(is, timeline,   '\t');
+	    std::getline(is, name,       '\t');
+	    std::getline(is, type,       '\t');
+	    std::getline(is, layout,     '\t');
+	    std::getline(is, cache_size, '\t');
+	    std::getline(is, file_size);
+	    if(!is) return false;
+	    try {
+	      entries[{timeline, name}] = {type, static_cast<Layout>(std::stoi(layout)), std::stoul(cache_size), std::stoul(file_size)};
+	    }
+	    catch(std::invalid_argument&) {return false;} // A corrupted manifest is discarded, the caller rescans.
+	    catch(std::out_of_range&)     {return false;}
 	  }
-	  return variables.try_emplace(var_symb,
-				       root_dir, var_symb,
-				       nullptr, std::nullopt, std::nullopt, false).first->second;
+	  else if(kind == "dir") {
+	    std::getline(is, time, '\t');
+	    std::getline(is, dir);
+	    if(!is) return false;
+	    try {
+	      dirs[dir] = fs::file_time_type(fs::file_time_type::duration(std::stoll(time)));
+	    }
+	    catch(std::invalid_argument&) {return false;}
+	    catch(std::out_of_range&)     {return false;}
+	  }
+	  else
+	    return false;
 	}
-	else
+
+	if(dirs.find(".") == dirs.end()) return false;
+	std::error_code ec;
+	for(auto& [dir, t] : dirs)
+	  if(auto current = fs::last_write_time(root_dir / dir, ec); ec || current != t)
+	    return false;
+	return true;
+      }
+
+      /**
+       * This realizes all the variable files of the root directory
+       * with nb_threads threads, and rewrites the manifest file.
+       */
+      void scan(std::size_t nb_threads) {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	dirs.clear();
+
+	if(!fs::exists(path)) std::ofstream(path).close(); // Creating it modifies root_dir.
+	
+	std::vector<fs::path> var_paths;
+	dirs["."] = fs::last_write_time(root_dir);
+	for(auto& elem: fs::recursive_directory_iterator(root_dir))
+	  if(auto p = elem.path(); elem.is_directory())
+	    dirs[relative(root_dir, p)] = fs::last_write_time(p);
+	  else if(p.extension() == ".var")
+	    var_paths.push_back(p);
+
+	auto prefix_length = symbol::parse::root_dir_length(root_dir);
+	std::vector<std::optional<Entry>> scanned(var_paths.size());
+	parallel_for(var_paths.size(), nb_threads, [this, prefix_length, &var_paths, &scanned](std::size_t i) {
+	    try {
+	      File file(root_dir, symbol::parse::split_varpath(prefix_length, var_paths[i]));
+	      file.realize(nullptr, std::nullopt, std::nullopt, false);
+	      scanned[i] = Entry {file.type_as_string(), file.get_layout(), file.get_cache_size(), file.get_file_size()};
+	    }
+	    catch(std::exception&) {} // Unreadable files are not recorded, they are realized when they are accessed.
+	  });
+	for(std::size_t i = 0; i < var_paths.size(); ++i)
+	  if(scanned[i]) entries[symbol::parse::split_varpath(prefix_length, var_paths[i])] = *(scanned[i]);
+
+	std::ofstream file(path, std::ios::trunc);
+	for(auto& [var, e] : entries) write_var(file, var, e);
+	for(auto& [dir, t] : dirs)    write_dir(file, dir, t);
+      }
+
+      /**
+       * This loads the manifest, or scans the variable files if it is stale.
+       */
+      void open(std::size_t nb_threads) {
+	if(!load()) scan(nb_threads);
+      }
+
+      /**
+       * This records a variable whose file has just been created.
+       */
+      void add(const symbol::Variable& var, const Entry& e) {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::ofstream os(path, std::ios::app);
+	write_var(os, var, e);
+	entries[var] = e;
+	for_each_dir_of(var, [this, &os](const std::string& dir) {
+	    auto t = fs::last_write_time(root_dir / dir);
+	    write_dir(os, dir, t);
+	    dirs[dir] = t;
+	  });
+      }
+    };
+
+    /**
+     * The center registers the variables. The registry is split into
+     * shards, each one being locked by a shared mutex: finding an
+     * existing variable only takes a shared lock on its shard, and
+     * the variable operations are then performed under the lock of
+     * the variable only.
+     */
+    class Center {
+    private:
+
+      struct Shard {
+	std::shared_mutex mutex;
+	std::map<symbol::Variable, Variable> variables;
+      };
+      
+      fs::path root_dir;
+      std::array<Shard, cxsom_NB_CENTER_SHARDS> shards;
+      std::unique_ptr<WriteBehind> write_behind; // Declared after shards, so that it is flushed before variables are destroyed.
+      std::unique_ptr<Manifest> manifest;
+      std::size_t nb_scan_threads = 1;
+
+      Shard& shard_of(const symbol::Variable& var_symb) {
+	std::size_t h = std::hash<std::string>()(var_symb.timeline) * 31 + std::hash<std::string>()(var_symb.name);
+	return shards[h % cxsom_NB_CENTER_SHARDS];
+      }
+
+      fs::path var_path(const symbol::Variable& var_symb) {
+	return root_dir / var_symb.timeline / (var_symb.name + ".var");
+      }
+
+      Variable* find_var(Shard& shard, const symbol::Variable& var_symb) {
+	std::shared_lock<std::shared_mutex> lock(shard.mutex);
+	if(auto it = shard.variables.find(var_symb); it != shard.variables.end())
+	  return &(it->second);
+	return nullptr;
+      }
+
+      // The variable is loaded from its file if it is not registered yet.
+      Variable& get_var(const symbol::Variable& var_symb, const std::string& caller) {
+	auto& shard = shard_of(var_symb);
+	if(auto var = find_var(shard, var_symb); var)
+	  return *var;
+	
+	std::unique_lock<std::shared_mutex> lock(shard.mutex);
+	if(auto it = shard.variables.find(var_symb); it != shard.variables.end())
 	  return it->second;
+	auto p = var_path(var_symb);
+	if(!fs::exists(p))  {
+	  std::ostringstream ostr;
+	  ostr << "cxsom::data::Center::" << caller << '(' << var_symb << "): variable doesn't exist yet.";
+	  throw error::unknown_variable(ostr.str());
+	}
+	return shard.variables.try_emplace(var_symb,
+					   root_dir, var_symb,
+					   nullptr, std::nullopt, std::nullopt, false, write_behind.get()).first->second;
+      }
+      
+      Variable& get_var(const symbol::Variable& var_symb) {
+	return get_var(var_symb, "get_var");
       }
       
     public:
@@ -1118,30 +1921,106 @@ namespace cxsom {
 	  fs::create_directory(root_dir);
       }
 
+      /**
+       * Ready instances are written by nb_io_threads dedicated threads
+       * through a queue of at most queue_capacity instances (see
+       * WriteBehind). No queue is used if nb_io_threads is 0.
+       */
+      Center(const fs::path& root_dir, std::size_t nb_io_threads, std::size_t queue_capacity)
+	: Center(root_dir) {
+	if(nb_io_threads > 0)
+	  write_behind = std::make_unique<WriteBehind>(nb_io_threads, queue_capacity);
+      }
+
+      /**
+       * Waits until all the ready instances are written in the files.
+       */
+      void flush() {
+	if(write_behind) write_behind->flush();
+      }
+
+      /**
+       * No other access to the center may be performed concurrently.
+       * The free payload buffers are given back to the system (see
+       * PayloadPool::trim).
+       */
       void clear() {
-	std::lock_guard<std::mutex> lock(mutex);
-	variables.clear();
+	flush();
+	for(auto& shard : shards) {
+	  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+	  shard.variables.clear();
+	}
+	PayloadPool::get().trim();
       }
 
-      instance_ref operator[](const symbol::Instance& var_inst) {
-	std::lock_guard<std::mutex> lock(mutex);
-	if(auto it = variables.find(var_inst); it != variables.end())
-	  return it->second[var_inst];
-	else {
-	  std::ostringstream ostr;
-	  ostr << "cxsom::data::Center::operator[" << var_inst << "]: variable doesn't exist yet.";
-	  throw error::unknown_variable(ostr.str());
+      /**
+       * This calls f(variable, statistics) for each variable
+       * registered so far.
+       */
+      template<typename Func>
+      void for_each_stats(const Func& f) {
+	for(auto& shard : shards) {
+	  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+	  for(auto& [var_symb, var] : shard.variables) f(var_symb, var.get_stats());
 	}
       }
 
+      /**
+       * The variable is realized from its file if it is not
+       * registered yet (with a manifest, check_all doesn't register
+       * the variables).
+       */
+      instance_ref operator[](const symbol::Instance& var_inst) {
+	return get_var(var_inst.variable, "operator[]")[var_inst.at];
+      }
+
+      /**
+       * See Variable::sync_busy.
+       */
+      std::vector<std::size_t> sync_busy(const symbol::Variable& var_symb, std::size_t from_at, std::size_t to_at) {
+	return get_var(var_symb, "sync_busy").sync_busy(from_at, to_at);
+      }
+
+      /**
+       * This is the file of the variable, which may not exist yet.
+       */
+      fs::path path_of(const symbol::Variable& var_symb) {return var_path(var_symb);}
+
       type::ref type_of(const symbol::Variable& var_symb) {
-	std::lock_guard<std::mutex> lock(mutex);
+	if(manifest && !find_var(shard_of(var_symb), var_symb))
+	  if(auto e = manifest->find(var_symb); e)
+	    return type::make(e->type); // The variable is not realized for this.
 	return get_var(var_symb).get_type();
       }
 
+      /**
+       * From now, the variables of the root directory are known from
+       * its manifest (see Manifest). It is rebuilt with nb_scan_threads
+       * threads if it is stale, and it records the variables created
+       * by check. The variable files are only opened when the
+       * variables are accessed.
+       */
+      void use_manifest(std::size_t nb_scan_threads) {
+	this->nb_scan_threads = nb_scan_threads;
+	manifest = std::make_unique<Manifest>(root_dir);
+	manifest->open(nb_scan_threads);
+      }
+
+      /**
+       * This is a handle on the variable, whose instances can then be
+       * fetched without any lookup in the center. It stays valid
+       * until clear() is called.
+       */
+      Variable& handle(const symbol::Variable& var_symb) {
+	return get_var(var_symb);
+      }
+
       std::size_t history_length(const symbol::Variable& var_symb) {
-	std::lock_guard<std::mutex> lock(mutex);
-	return get_var(var_symb).history_length();
+	return get_var(var_symb, "history_length").history_length();
+      }
+
+      std::size_t file_size_of(const symbol::Variable& var_symb) {
+	return get_var(var_symb, "file_size_of").get_file_size();
       }
 
       /**
@@ -1149,38 +2028,58 @@ namespace cxsom {
        * currently in the root directory and their type.
        */
       void check_all() {
+	if(manifest) {
+	  manifest->open(nb_scan_threads);
+	  return;
+	}
 	auto prefix_length = cxsom::symbol::parse::root_dir_length(root_dir);
 	for(auto& elem: fs::recursive_directory_iterator(root_dir))
 	  if(auto p = elem.path(); p.extension() == ".var")
-	    touch_var(cxsom::symbol::parse::split_varpath(prefix_length, p));	    
+	    get_var(cxsom::symbol::parse::split_varpath(prefix_length, p), "touch_var");	    
       }
       
       /**
        * This makes the variable exist or retreive the existing
        * one. It fails if, in case of retrieval, the type is not the
-       * type that we check.
+       * type that we check. In memory variables have no file in the
+       * root directory (see File::realize_in_memory).
        */
       void check(const symbol::Variable& var_symb,
 		 type::ref type,
 		 std::optional<std::size_t> cache_size,
 		 std::optional<std::size_t> file_size,
-		 bool kept_opened) {
-	std::lock_guard<std::mutex> lock(mutex);
-	if(auto it = variables.find(var_symb); it == variables.end()) {
-	  auto p = var_path(var_symb);
-	  auto d = p;
-	  d.remove_filename();
-	  if(!fs::exists(d)) fs::create_directories(d);
-
-	  variables.try_emplace(var_symb,
-				root_dir, var_symb,
-				type,
-				cache_size, file_size, kept_opened);
+		 bool kept_opened,
+		 bool in_memory = false) {
+	auto& shard = shard_of(var_symb);
+	auto var = find_var(shard, var_symb);
+	if(!var) {
+	  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+	  if(auto it = shard.variables.find(var_symb); it == shard.variables.end()) {
+	    bool created = false;
+	    if(!in_memory) {
+	      auto p = var_path(var_symb);
+	      auto d = p;
+	      d.remove_filename();
+	      if(!fs::exists(d)) fs::create_directories(d);
+	      created = !fs::exists(p);
+	    }
+	    
+	    auto& var = shard.variables.try_emplace(var_symb,
+						    root_dir, var_symb,
+						    type,
+						    cache_size, file_size, kept_opened, write_behind.get(), in_memory).first->second;
+	    if(manifest && created)
+	      manifest->add(var_symb, {var.get_type()->name(), var.get_layout(), var.get_cache_size(), var.get_file_size()});
+	    return;
+	  }
+	  else
+	    var = &(it->second);
 	}
-	else if(auto vtype = it->second.get_type(); *type != *vtype) {
+	
+	if(auto vtype = var->get_type(); *type != *vtype) {
 	  std::ostringstream ostr;
 	  ostr << "cxsom::data::Center::check : "
-	       << "Checking for " << type->name() << " while variable " << it->first << " contains " << vtype->name() << ".";
+	       << "Checking for " << type->name() << " while variable " << var_symb << " contains " << vtype->name() << ".";
 	  throw error::type_mismatch(ostr.str());
 	}
       }
@@ -5,20 +5,20 @@
 #include <utility> // should be included by asio
 #include <asio.hpp>
 
+#include <cxsomEndpoint.hpp>
+
 int main(int argc, char* argv[]) {
   if(argc != 3) {
-    std::cout << "Usage : " << argv[0] << " <hostname> <port>" << std::endl;
+    std::cout << "Usage : " << argv[0] << " <hostname> <port|unix:/path>" << std::endl;
     return 0;
   }
 
   std::string hostname(argv[1]);
   std::string port    (argv[2]);
   
-  
-  asio::ip::tcp::iostream socket;
-  socket.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
   try {
-    socket.connect(hostname, port);
+    auto p_socket = cxsom::endpoint::connect(hostname, port);
+    auto& socket = *p_socket;
 
     socket << "ping\n" << std::flush;
     
@@ -0,0 +1,43 @@
+#include <string>
+#include <iostream>
+
+#include <utility> // should be included by asio
+#include <asio.hpp>
+
+#include <cxsomEndpoint.hpp>
+
+int main(int argc, char* argv[]) {
+  if(!(argc == 5 && std::string(argv[3]) == "on") && !(argc == 4 && std::string(argv[3]) == "off")) {
+    std::cout << "Usage : " << std::endl
+	      << "  " << argv[0] << " <hostname> <port|unix:/path> on <capture.txt>" << std::endl
+	      << "  " << argv[0] << " <hostname> <port|unix:/path> off" << std::endl
+	      << std::endl
+	      << "The capture file is written by the processor, in its working directory if the path is relative." << std::endl
+	      << "It can be sent again with cxsom-replay." << std::endl;
+    return 0;
+  }
+
+  std::string hostname(argv[1]);
+  std::string port    (argv[2]);
+  
+  try {
+    auto p_socket = cxsom::endpoint::connect(hostname, port);
+    auto& socket = *p_socket;
+
+    if(argc == 5)
+      socket << "record on " << argv[4] << "\n" << std::flush;
+    else
+      socket << "record off\n" << std::flush;
+  
+    std::string line;
+    std::getline(socket, line, '\n');
+    if(line != "ok")
+      std::cerr << line << std::endl;
+  }
+  catch(std::exception& e) {
+    std::cerr << "Exception caught : " << e.what() << " --> " << typeid(e).name()<< std::endl;
+  }
+  
+  
+  return 0;
+}
@@ -0,0 +1,149 @@
+#include <utility> // should be included by asio
+#include <asio.hpp>
+#include <skednet.hpp>
+
+#include <cxsom-processor.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = nullptr;
+cxsom::Monitor* cxsom::monitor = nullptr;
+
+// The computation is considered as finished when no task has been
+// executed for that duration (ms).
+#ifndef cxsom_REPLAY_QUIET_MS
+#define cxsom_REPLAY_QUIET_MS 500
+#endif
+
+struct Command {
+  std::uint64_t us;
+  unsigned int  connection;
+  std::string   line;
+};
+
+std::uint64_t nb_tasks() {
+  std::uint64_t res = 0;
+  cxsom::stats::Registry::get().for_each_worker([&res](std::size_t, const cxsom::stats::Worker& w) {res += w.nb_tasks;});
+  return res;
+}
+
+int main(int argc, char* argv[]) {
+  if(argc != 5 || (std::string(argv[4]) != "fast" && std::string(argv[4]) != "paced")) {
+    std::cout << "Usage : " << argv[0] << " <root-dir> <nb-threads> <capture.txt> <fast|paced>" << std::endl
+	      << std::endl
+	      << "The commands of the capture (see cxsom-record) are sent to a processor running in this" << std::endl
+	      << "process, on <root-dir>, either as fast as possible or at the recorded pace. The data" << std::endl
+	      << "written into the variable files by the clients are not in the capture, so replay on a" << std::endl
+	      << "copy of the root directory as it was when the recording started. The results are" << std::endl
+	      << "printed in JSON." << std::endl;
+    return 0;
+  }
+
+  std::string root_dir   =           argv[1] ;
+  int         nb_threads = std::stoi(argv[2]);
+  bool        paced      = std::string(argv[4]) == "paced";
+
+  std::vector<Command> commands;
+  {
+    std::ifstream file(argv[3]);
+    if(!file) {
+      std::cerr << "Cannot read \"" << argv[3] << "\"." << std::endl;
+      return 1;
+    }
+    std::string line;
+    while(std::getline(file, line)) {
+      if(line.empty() || line[0] == '#') continue;
+      std::istringstream is(line);
+      Command c;
+      is >> c.us >> c.connection >> std::ws;
+      std::getline(is, c.line);
+      commands.push_back(c);
+    }
+  }
+
+  std::random_device rd;
+  cxsom::jobs::UpdateFactory update_factory;
+  cxsom::jobs::fill(update_factory);
+  cxsom::jobs::TypeChecker type_checker;
+  cxsom::jobs::fill(type_checker);
+  cxsom::data::Center data_center(root_dir, cxsom_NB_IO_THREADS, cxsom_WRITE_QUEUE_CAPACITY);
+  if(cxsom_MANIFEST_SCAN_THREADS > 0) data_center.use_manifest(cxsom_MANIFEST_SCAN_THREADS);
+  cxsom::jobs::Center jobs_center(rd, update_factory, type_checker, data_center, nullptr);
+
+  for(int w = 0; w < nb_threads; ++w)
+    std::thread([&jobs_center](){jobs_center.worker_thread();}).detach();
+
+  // The processor listens on a local port chosen by the system.
+  asio::io_service        ios;
+  asio::ip::tcp::acceptor acceptor(ios, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+  std::string port = std::to_string(acceptor.local_endpoint().port());
+  std::thread([&data_center, &jobs_center, &acceptor]() {
+      while(true) std::thread(cxsom::processor::ServiceThread(data_center, jobs_center, acceptor)).detach();
+    }).detach();
+
+  // Each recorded connection is replayed by a connection of its own.
+  std::map<unsigned int, std::unique_ptr<asio::ip::tcp::iostream>> sockets;
+  unsigned int nb_errors = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(auto& c : commands) {
+    if(paced) std::this_thread::sleep_until(start + std::chrono::microseconds(c.us));
+    auto& socket = sockets[c.connection];
+    if(!socket) {
+      socket = std::make_unique<asio::ip::tcp::iostream>();
+      socket->exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
+      socket->connect("127.0.0.1", port);
+    }
+    *socket << c.line << '\n' << std::flush;
+    if(c.line.substr(0, c.line.find(' ')) == "updates") continue; // The static and pattern lines are answered.
+    std::string answer;
+    std::getline(*socket, answer);
+    if(answer != "ok" && nb_errors++ < 10)
+      std::cerr << c.line << " --> " << answer << std::endl;
+  }
+  auto fed = std::chrono::steady_clock::now();
+
+  auto last_tasks  = nb_tasks();
+  auto last_change = fed;
+  while(std::chrono::steady_clock::now() - last_change < std::chrono::milliseconds(cxsom_REPLAY_QUIET_MS)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if(auto n = nb_tasks(); n != last_tasks) {
+      last_tasks  = n;
+      last_change = std::chrono::steady_clock::now();
+    }
+  }
+  data_center.flush();
+
+  auto& gauges = cxsom::stats::Registry::get().timesteps;
+  std::int64_t pending = 0;
+  for(std::size_t s = 0; s < gauges.count.size(); ++s)
+    if(s != cxsom::timestep::status_index(cxsom::timestep::Status::Done)) pending += gauges.count[s];
+
+  std::chrono::duration<double> feeding     = fed - start;
+  std::chrono::duration<double> computation = last_change - start;
+  std::cout << "{" << std::endl
+	    << "  \"mode\": \"" << argv[4] << "\"," << std::endl
+	    << "  \"commands\": " << commands.size() << ',' << std::endl
+	    << "  \"connections\": " << sockets.size() << ',' << std::endl
+	    << "  \"errors\": " << nb_errors << ',' << std::endl
+	    << "  \"feeding\": " << feeding.count() << ',' << std::endl
+	    << "  \"duration\": " << computation.count() << ',' << std::endl
+	    << "  \"tasks\": " << last_tasks << ',' << std::endl
+	    << "  \"tasks_per_second\": " << last_tasks / computation.count() << ',' << std::endl
+	    << "  \"pending_timesteps\": " << pending << std::endl
+	    << "}" << std::endl;
+
+  // The workers never end.
+  std::quick_exit(0);
+}
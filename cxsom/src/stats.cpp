@@ -0,0 +1,46 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+
+#include <utility> // should be included by asio
+#include <asio.hpp>
+
+#include <cxsomEndpoint.hpp>
+
+int main(int argc, char* argv[]) {
+  if(argc != 3) {
+    std::cout << "Usage : " << argv[0] << " <hostname> <port|unix:/path>" << std::endl;
+    return 0;
+  }
+
+  std::string hostname(argv[1]);
+  std::string port    (argv[2]);
+  
+  try {
+    auto p_socket = cxsom::endpoint::connect(hostname, port);
+    auto& socket = *p_socket;
+
+    socket << "stats\n" << std::flush;
+  
+    std::string line;
+    std::getline(socket, line, '\n');
+    std::istringstream answer(line);
+    std::string ok;
+    std::size_t nb_lines = 0;
+    answer >> ok >> nb_lines;
+    if(ok != "ok") {
+      std::cerr << line << std::endl;
+      return 0;
+    }
+    for(std::size_t l = 0; l < nb_lines; ++l) {
+      std::getline(socket, line, '\n');
+      std::cout << line << std::endl;
+    }
+  }
+  catch(std::exception& e) {
+    std::cerr << "Exception caught : " << e.what() << " --> " << typeid(e).name()<< std::endl;
+  }
+  
+  
+  return 0;
+}
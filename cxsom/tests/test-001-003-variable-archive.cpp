@@ -0,0 +1,60 @@
+#include <cxsom-server.hpp>
+#include <cxsomArchive.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#include <iostream>
+#include <iomanip>
+
+int main(int, char**) {
+  fs::path root_dir    = fs::current_path() / "my_center";
+  fs::path archive_dir = fs::current_path() / "my_archive";
+  cxsom::symbol::Variable var_symb {"timeline", "foo"};
+  auto type = cxsom::type::make("Pos1D");
+
+  {
+    // We fill a 10-sized buffer with 25 values, some of them are left busy.
+    cxsom::data::File file(root_dir, var_symb);
+    file.realize(type, 1, 10, false);
+    auto d = cxsom::data::make(type);
+    for(std::size_t at = 0; at < 25; ++at)
+      if(at % 7 != 3) {
+	static_cast<cxsom::data::d1::Pos&>(*d).x = at;
+	file.write(at, d);
+      }
+  }
+
+  std::cout << cxsom::data::Archive::build(root_dir, archive_dir, var_symb) << " ready instances archived." << std::endl;
+
+  cxsom::data::File file(root_dir, var_symb);
+  file.realize(nullptr, std::nullopt, std::nullopt, false);
+  cxsom::data::Archive archive(archive_dir, var_symb);
+  archive.realize();
+  
+  auto [first, last] = archive.get_time_range();
+  std::cout << "Archived range is [" << first << ", " << last << "]." << std::endl;
+
+  auto from_file    = cxsom::data::make(type);
+  auto from_archive = cxsom::data::make(type);
+  for(std::size_t at = 0; at < 30; ++at) {
+    auto a_file    = file.read(at, from_file);
+    auto a_archive = archive.read(at, from_archive);
+    std::cout << std::setw(3) << at << " : " << a_file << '/' << a_archive;
+    if(a_archive == cxsom::data::FileAvailability::Ready)
+      std::cout << " : " << static_cast<const cxsom::data::d1::Pos&>(*from_archive).x;
+    if(a_file != a_archive
+       || (a_file == cxsom::data::FileAvailability::Ready
+	   && static_cast<const cxsom::data::d1::Pos&>(*from_file).x != static_cast<const cxsom::data::d1::Pos&>(*from_archive).x))
+      std::cout << " <-- mismatch";
+    std::cout << std::endl;
+  }
+  
+  return 0;
+}
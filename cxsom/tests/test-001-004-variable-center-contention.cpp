@@ -0,0 +1,57 @@
+#include <cxsom-server.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <string>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#define NB_VARIABLES  64
+#define NB_INSTANCES  10
+#define NB_LOOKUPS    200000
+
+// Each thread fetches instances and types of all the variables, as
+// the update constructors of parallel workers do. The throughput
+// should increase with the number of threads, since lookups of
+// different variables do not queue behind a single lock.
+int main(int, char**) {
+  cxsom::data::Center center(fs::current_path() / "contention");
+
+  std::vector<cxsom::symbol::Variable> variables;
+  for(unsigned int v = 0; v < NB_VARIABLES; ++v) {
+    variables.emplace_back("main", std::string("X") + std::to_string(v));
+    center.check(variables.back(), cxsom::type::make("Map1D<Scalar>=100"), NB_INSTANCES, 0, false);
+  }
+
+  unsigned int max_threads = std::max(8u, std::thread::hardware_concurrency());
+  for(unsigned int nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(unsigned int t = 0; t < nb_threads; ++t)
+      threads.emplace_back([&center, &variables, t]() {
+	  for(unsigned int i = 0; i < NB_LOOKUPS; ++i) {
+	    auto& var = variables[(i + t) % NB_VARIABLES];
+	    auto inst = center[cxsom::symbol::Instance(var, i % NB_INSTANCES)];
+	    auto type = center.type_of(var);
+	  }
+	});
+    for(auto& thread : threads) thread.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << nb_threads << " thread(s) : "
+	      << (unsigned int)(nb_threads * NB_LOOKUPS / elapsed.count()) << " lookups/s" << std::endl;
+  }
+
+  std::cout << std::endl
+	    << "Execute : rm -rf contention" << std::endl
+	    << std::endl;
+  return 0;
+}
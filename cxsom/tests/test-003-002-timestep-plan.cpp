@@ -0,0 +1,59 @@
+#include <cxsom-server.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <iostream>
+#include <string>
+
+// This is the update graph of a relaxation timeline, as the builder
+// makes for two maps X and Y. Each variable is mapped to (has_init,
+// in-args). Only the in-args (the arguments in the same timestep)
+// are relevant here.
+int main(int, char**) {
+  cxsom::timestep::Plan::graph g;
+  g["Xe"]   = {false, {}};              // external matches read other timelines only.
+  g["Ye"]   = {false, {}};
+  g["Xc"]   = {false, {"Ybmu"}};        // contextual matches read the other map.
+  g["Yc"]   = {false, {"Xbmu"}};
+  g["X"]    = {false, {"Xe", "Xc"}};    // merges.
+  g["Y"]    = {false, {"Ye", "Yc"}};
+  g["Xbmu"] = {true,  {"X", "Xbmu"}};   // toward-argmax, with an init.
+  g["Ybmu"] = {true,  {"Y", "Ybmu"}};
+  g["Xout"] = {false, {"Xbmu"}};        // This reads the relaxation result.
+  g["Xin"]  = {false, {"Xe"}};          // This only depends on planned updates.
+
+  cxsom::timestep::Plan plan(g);
+  std::cout << plan << std::endl;
+
+  for(auto name : {"Xe", "Xin", "X", "Xbmu", "Xout"}) {
+    auto node = plan(name);
+    std::cout << name << " : rank = " << node->rank
+	      << ", loop = " << std::boolalpha << node->loop
+	      << ", planned = " << node->planned << ", preds = {";
+    for(auto& pred : node->preds) std::cout << ' ' << pred;
+    std::cout << " }" << std::endl;
+  }
+  std::cout << std::endl;
+
+  // Cross-timeline case : T1/Z = copy(T2/X@t), T1/B = random, and
+  // T2/X = copy(T1/B@t). In T1, Z and B are both planned, with
+  // different ranks, but Z has no predecessor in T1 so B must not
+  // wait for it (Z waits for T2/X, which waits for B).
+  cxsom::timestep::Plan::graph g1;
+  g1["Z"] = {false, {}};                // T2/X@t is not an in-arg of T1.
+  g1["B"] = {false, {}};
+  cxsom::timestep::Plan plan1(g1);
+  std::cout << plan1 << std::endl;
+  for(auto name : {"Z", "B"}) {
+    auto node = plan1(name);
+    std::cout << name << " : rank = " << node->rank
+	      << ", planned = " << std::boolalpha << node->planned
+	      << ", nb preds = " << node->preds.size() << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include <cxsom-server.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <random>
+#include <thread>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <iostream>
+#include <cstdlib>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+// This is the total time spent by the fake operations.
+std::atomic<std::uint64_t> compute_ns {0};
+
+// This fake operation takes "cost" µs of busy work, and its result
+// changes at the "iterations" first computations of a timestep. A
+// cycle of such updates thus converges after about that number of
+// relaxation steps.
+class Fake : public cxsom::jobs::Base {
+private:
+  std::chrono::nanoseconds cost;
+  unsigned int iterations;
+  unsigned int nb_writes = 0;
+
+public:
+
+  Fake(cxsom::data::Center& center,
+       const cxsom::update::arg& res,
+       const std::vector<cxsom::update::arg>& args,
+       const std::map<std::string, std::string>& params)
+    : Base(center, res, "fake", args), cost(0), iterations(1) {
+    if(auto it = params.find("cost");       it != params.end()) cost       = std::chrono::nanoseconds((long)(std::stod(it->second) * 1000));
+    if(auto it = params.find("iterations"); it != params.end()) iterations = std::stoul(it->second);
+  }
+
+protected:
+
+  virtual void on_rebind() override {nb_writes = 0;}
+
+  virtual bool on_write_result(cxsom::data::Base& data) override {
+    auto start = std::chrono::steady_clock::now();
+    while(std::chrono::steady_clock::now() - start < cost);
+    compute_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if(nb_writes++ < iterations) {
+      static_cast<cxsom::data::Scalar&>(data).value += 1;
+      return true;
+    }
+    return false;
+  }
+};
+
+std::string var_name(unsigned int v) {return std::string("X") + std::to_string(v);}
+std::string tl_name (unsigned int t) {return std::string("tl") + std::to_string(t);}
+
+// The scheduler runs on in-memory scalar variables, with fake
+// operations, so that its cost is not hidden by computation or I/O.
+int main(int argc, char* argv[]) {
+  if(argc != 9) {
+    std::cout << "Usage : " << argv[0] << " <nb-workers> <dag|cycle> <nb-timelines> <nb-variables> <nb-timesteps> <cost-us> <iterations> <blocking-probability>" << std::endl
+	      << std::endl
+	      << "Each timeline has nb-variables variables. Each one reads its previous value and, in the" << std::endl
+	      << "same timestep, its predecessors (dag) or its neighbours (cycle) in the timeline. With the" << std::endl
+	      << "blocking probability, it also reads the previous value of a variable of another timeline." << std::endl
+	      << "The updates take cost-us µs and change their result iterations times per timestep." << std::endl
+	      << "e.g. " << argv[0] << " 4 cycle 8 10 100 20 3 .2" << std::endl;
+    return 0;
+  }
+
+  unsigned int nb_workers   = std::stoul(argv[1]);
+  bool         cyclic       = std::string(argv[2]) == "cycle";
+  unsigned int nb_timelines = std::stoul(argv[3]);
+  unsigned int nb_variables = std::stoul(argv[4]);
+  unsigned int nb_timesteps = std::stoul(argv[5]);
+  std::string  cost         =            argv[6] ;
+  std::string  iterations   =            argv[7] ;
+  double       blocking     = std::stod (argv[8]);
+
+  std::random_device rd;
+  std::mt19937 gen(0);
+  std::bernoulli_distribution blocks(blocking);
+  cxsom::data::Center data_center(fs::current_path() / "sim");
+
+  cxsom::jobs::UpdateFactory update_factory;
+  cxsom::jobs::fill(update_factory);
+  update_factory += {"fake", cxsom::jobs::make_update_deterministic<Fake>};
+
+  cxsom::jobs::TypeChecker type_checker;
+  cxsom::jobs::fill(type_checker);
+  type_checker += {"fake", [](cxsom::type::ref, const std::vector<cxsom::type::ref>&) {}};
+
+  cxsom::jobs::Center jobs_center(rd, update_factory, type_checker, data_center, nullptr);
+
+  for(unsigned int t = 0; t < nb_timelines; ++t)
+    for(unsigned int v = 0; v < nb_variables; ++v)
+      data_center.check({tl_name(t), var_name(v)}, cxsom::type::make("Scalar"), nb_timesteps, 0, false, true);
+
+  std::vector<std::thread> workers;
+  for(unsigned int i = 0; i < nb_workers; ++i)
+    workers.emplace_back([&jobs_center](){jobs_center.worker_thread();});
+
+  auto start = std::chrono::steady_clock::now();
+  jobs_center.interaction_lock();
+  unsigned int nb_in_args = 0, nb_blockers = 0;
+  for(unsigned int t = 0; t < nb_timelines; ++t)
+    for(unsigned int v = 0; v < nb_variables; ++v) {
+      jobs_center += cxsom::jobs::make({tl_name(t), var_name(v), 0}, {"clear", {}, {}});
+      std::vector<cxsom::symbol::pattern::ArgInstance> args {{tl_name(t), var_name(v), -1_relative}};
+      if(cyclic) {
+	if(nb_variables > 1) args.push_back({tl_name(t), var_name((v + nb_variables - 1) % nb_variables), 0_relative});
+	if(nb_variables > 2) args.push_back({tl_name(t), var_name((v + 1) % nb_variables), 0_relative});
+      }
+      else
+	for(unsigned int p = (v < 2 ? 0 : v - 2); p < v; ++p) args.push_back({tl_name(t), var_name(p), 0_relative});
+      nb_in_args += args.size() - 1;
+      if(nb_timelines > 1 && blocks(gen)) {
+	auto other = (t + 1 + gen() % (nb_timelines - 1)) % nb_timelines;
+	args.push_back({tl_name(other), var_name(gen() % nb_variables), -1_relative});
+	++nb_blockers;
+      }
+      jobs_center += cxsom::jobs::pattern::make({tl_name(t), var_name(v)}, {"fake", args, {{"cost", cost}, {"iterations", iterations}}}, nb_timesteps - 1);
+    }
+  jobs_center.interaction_release();
+
+  for(unsigned int t = 0; t < nb_timelines; ++t)
+    for(unsigned int v = 0; v < nb_variables; ++v)
+      while(data_center[cxsom::symbol::Instance(tl_name(t), var_name(v), nb_timesteps - 1)]->get_status() != cxsom::data::Availability::Ready)
+	std::this_thread::sleep_for(20us);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  auto& registry = cxsom::stats::Registry::get();
+  std::uint64_t nb_tasks = 0, busy = 0, scheduling = 0, idle = 0;
+  std::string per_worker;
+  registry.for_each_worker([&](std::size_t, const cxsom::stats::Worker& w) {
+      per_worker += " " + std::to_string(w.nb_tasks);
+      nb_tasks   += w.nb_tasks;
+      busy       += w.busy;
+      scheduling += w.scheduling;
+      idle       += w.idle;
+    });
+  std::uint64_t task_ns = 0;
+  registry.for_each_operation([&task_ns](const std::string& name, const cxsom::stats::Operation& op) {
+      if(name == "fake") task_ns = op.duration;
+    });
+
+  // The tasks are the computations of the updates, the overhead is
+  // what the workers do apart from the fake computation.
+  double us = 1e-3;
+  std::cout << "graph          : " << nb_timelines << " timeline(s) of " << nb_variables << " variable(s), " << (cyclic ? "cyclic" : "acyclic")
+	    << ", " << nb_in_args << " in-arg(s), " << nb_blockers << " blocking out-arg(s)" << std::endl
+	    << "duration       : " << elapsed.count() << "s for " << nb_timesteps << " timesteps" << std::endl
+	    << "tasks          : " << nb_tasks << " (" << nb_tasks / double(nb_timelines * nb_variables * nb_timesteps) << " per instance)" << std::endl
+	    << "tasks/worker   :" << per_worker << std::endl
+	    << "compute        : " << compute_ns * us / nb_tasks << "µs per task" << std::endl
+	    << "task overhead  : " << (task_ns - compute_ns) * us / nb_tasks << "µs per task (update execution)" << std::endl
+	    << "sched overhead : " << (busy - task_ns + scheduling) * us / nb_tasks << "µs per task (task finding and bookkeeping)" << std::endl
+	    << "worker idle    : " << idle * 1e-9 / (nb_workers * elapsed.count()) * 100 << "%" << std::endl;
+  registry.for_each_lock([](const std::string& name, const cxsom::stats::Lock& l) {
+      std::cout << "lock " << name << " : " << l.acquisitions << " acquisitions, " << l.contended << " contended, "
+		<< l.waiting * 1e-6 << "ms waiting" << std::endl;
+    });
+
+  // The workers never end.
+  std::quick_exit(0);
+}
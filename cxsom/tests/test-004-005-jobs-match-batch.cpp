@@ -0,0 +1,115 @@
+#include <cxsom-server.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <random>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+// This mimics a frozen sweep (see cxsom::builder::Architecture::frozen)
+// against fixed weights. Three timelines compute the same matches and
+// BMUs:
+// - zref : the input is copied in the timeline first, so the matches
+//          cannot be batched (this is the usual update path).
+// - zful : the matches are batched and recorded.
+// - zfrz : the matches are batched and kept in memory, with no file,
+//          as frozen layers are with PARTIAL_RECORD.
+
+#define NB_UNITS  500
+#define DIM        16
+#define NB_STEPS 1000
+
+std::vector<double> content(cxsom::data::Center& data_center, const cxsom::symbol::Instance& who) {
+  std::vector<double> res;
+  data_center[who]->get([&res](auto status, auto, auto& data) {
+      if(status != cxsom::data::Availability::Ready) return;
+      auto [begin, end] = data.data_range();
+      res.assign(begin, end);
+    });
+  return res;
+}
+
+int main(int, char**) {
+  std::random_device rd;
+  auto root_dir = fs::current_path() / "tmp-match-batch";
+  fs::remove_all(root_dir);
+  cxsom::data::Center data_center(root_dir);
+
+  cxsom::jobs::UpdateFactory update_factory;
+  cxsom::jobs::fill(update_factory);
+
+  cxsom::jobs::TypeChecker type_checker;
+  cxsom::jobs::fill(type_checker);
+
+  cxsom::jobs::Center jobs_center(rd, update_factory, type_checker, data_center, nullptr);
+
+  auto map_type   = cxsom::type::make("Map1D<Scalar>=" + std::to_string(NB_UNITS));
+  auto bmu_type   = cxsom::type::make("Pos1D");
+  auto input_type = cxsom::type::make("Array=" + std::to_string(DIM));
+  data_center.check({"wgt",  "W"},   cxsom::type::make("Map1D<Array=" + std::to_string(DIM) + ">=" + std::to_string(NB_UNITS)), 1, 1, false);
+  data_center.check({"in",   "X"},   input_type, 2, NB_STEPS, false);
+  data_center.check({"zref", "X"},   input_type, 2, 0,        false);
+  data_center.check({"zref", "A"},   map_type,   2, NB_STEPS, false);
+  data_center.check({"zful", "A"},   map_type,   2, NB_STEPS, false);
+  data_center.check({"zfrz", "A"},   map_type,   2, 0,        false, true);
+  for(auto timeline : {"zref", "zful", "zfrz"})
+    data_center.check({timeline, "BMU"}, bmu_type, 2, NB_STEPS, false);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  auto fill = [&gen, &uniform](auto&, auto& datation, auto& data) {
+    auto [begin, end] = data.data_range();
+    std::generate(begin, end, [&gen, &uniform]() {return uniform(gen);});
+    datation = 1;
+  };
+  data_center[cxsom::symbol::Instance({"wgt", "W"}, 0)]->set([&fill](auto& status, auto& datation, auto& data) {fill(status, datation, data); status = cxsom::data::Availability::Ready;});
+  for(unsigned int at = 0; at < NB_STEPS; ++at)
+    data_center[cxsom::symbol::Instance({"in", "X"}, at)]->set([&fill](auto& status, auto& datation, auto& data) {fill(status, datation, data); status = cxsom::data::Availability::Ready;});
+
+  cxsom::symbol::pattern::ArgInstance weights {"wgt", "W", 0_absolute};
+  jobs_center += cxsom::jobs::pattern::make({"zref", "X"}, {"copy", {{"in", "X", 0_relative}}, {}}, NB_STEPS - 1);
+  jobs_center += cxsom::jobs::pattern::make({"zref", "A"}, {"match-gaussian", {{"zref", "X", 0_relative}, weights}, {{"sigma", ".5"}}}, NB_STEPS - 1);
+  for(auto timeline : {"zful", "zfrz"})
+    jobs_center += cxsom::jobs::pattern::make({timeline, "A"}, {"match-gaussian", {{"in", "X", 0_relative}, weights}, {{"sigma", ".5"}}}, NB_STEPS - 1);
+  for(auto timeline : {"zref", "zful", "zfrz"})
+    jobs_center += cxsom::jobs::pattern::make({timeline, "BMU"}, {"argmax", {{timeline, "A", 0_relative}}, {}}, NB_STEPS - 1);
+
+  auto start = std::chrono::steady_clock::now();
+  bool has_work = true;
+  while(has_work)
+    if(auto job = jobs_center.get_one(); job) job();
+    else has_work = false;
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+  auto& batches = cxsom::stats::Registry::get().operation("match-gaussian/batch");
+  auto& updates = cxsom::stats::Registry::get().operation("match-gaussian");
+  std::cout << NB_STEPS << " timesteps x 3 timelines computed in " << duration.count() << "s." << std::endl
+	    << "  match updates  : " << updates.nb_tasks << std::endl
+	    << "  match batches  : " << batches.nb_tasks << " (" << batches.duration * 1e-9 << "s)" << std::endl;
+
+  unsigned int nb_errors = 0;
+  for(unsigned int at = 0; at < NB_STEPS; ++at) {
+    auto ref_a = content(data_center, {{"zref", "A"}, at});
+    if(ref_a.empty() || content(data_center, {{"zful", "A"}, at}) != ref_a) ++nb_errors;
+    auto ref_bmu = content(data_center, {{"zref", "BMU"}, at});
+    for(auto timeline : {"zful", "zfrz"})
+      if(ref_bmu.empty() || content(data_center, {{timeline, "BMU"}, at}) != ref_bmu) ++nb_errors;
+  }
+  std::cout << "  mismatches     : " << nb_errors << std::endl;
+
+  if(batches.nb_tasks == 0 || updates.nb_tasks >= 2 * NB_STEPS || nb_errors > 0) {
+    std::cout << "Failed." << std::endl;
+    return 1;
+  }
+  std::cout << "Ok." << std::endl;
+  return 0;
+}
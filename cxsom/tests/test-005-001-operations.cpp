@@ -2211,7 +2211,7 @@ namespace test {
 
 	  collection[0]->get([&collection_Scalar](auto status, auto, auto& data) {
 	    if(status == cxsom::data::Availability::Ready)
-	      collection_Scalar = static_cast<const cxsom::data::Map&>(data).content;
+	      collection_Scalar.assign(static_cast<const cxsom::data::Map&>(data).content.begin(), static_cast<const cxsom::data::Map&>(data).content.end());
 	    else
 	      throw std::runtime_error("Busy slot found in collection");
 	  });
@@ -2227,7 +2227,7 @@ namespace test {
 
 	  collection[0]->get([&collection_Pos1D](auto status, auto, auto& data) {
 	    if(status == cxsom::data::Availability::Ready)
-	      collection_Pos1D = static_cast<const cxsom::data::Map&>(data).content;
+	      collection_Pos1D.assign(static_cast<const cxsom::data::Map&>(data).content.begin(), static_cast<const cxsom::data::Map&>(data).content.end());
 	    else
 	      throw std::runtime_error("Busy slot found in collection");
 	  });
@@ -2254,7 +2254,7 @@ namespace test {
 	  for(std::size_t at = 0; at < history_size; ++at)
 	    res[at]->get([&res_Array](auto status, auto, auto& data) {
 	      if(status == cxsom::data::Availability::Ready)
-		res_Array.push_back(static_cast<const cxsom::data::Array&>(data).content);
+		res_Array.emplace_back(static_cast<const cxsom::data::Array&>(data).content.begin(), static_cast<const cxsom::data::Array&>(data).content.end());
 	      else
 		throw std::runtime_error("Busy slot found in res");
 	    });
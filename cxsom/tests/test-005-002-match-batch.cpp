@@ -0,0 +1,66 @@
+#include <cxsom-server.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#define NB_UNITS  2000
+#define DIM         64
+#define NB_INPUTS 1000
+
+int main(int, char**) {
+  cxsom::jobs::UpdateFactory update_factory;
+  cxsom::jobs::fill(update_factory);
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<double> weights(NB_UNITS * DIM);
+  std::vector<double> inputs(NB_INPUTS * DIM);
+  std::vector<double> results(NB_INPUTS * NB_UNITS);
+  std::vector<double> expected(NB_INPUTS * NB_UNITS);
+  for(auto& w : weights) w = uniform(gen);
+  for(auto& x : inputs)  x = uniform(gen);
+
+  for(auto [op, param, value] : {std::tuple<std::string, std::string, std::string>{"match-gaussian", "sigma", ".2"},
+				 std::tuple<std::string, std::string, std::string>{"match-triangle", "r",     ".5"}}) {
+    auto batch = update_factory.batch(op, {{param, value}});
+
+    // This is what the match updates compute, one input at a time.
+    double a = 0;
+    if(op == "match-gaussian") a = .5/(std::stod(value) * std::stod(value));
+    else                       a = 1/std::stod(value);
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t i = 0; i < NB_INPUTS; ++i)
+      for(std::size_t u = 0; u < NB_UNITS; ++u)
+	if(op == "match-gaussian") expected[i * NB_UNITS + u] = cxsom::match::gaussian(DIM, a, std::data(weights) + u * DIM, std::data(inputs) + i * DIM);
+	else                       expected[i * NB_UNITS + u] = cxsom::match::triangle(DIM, a, std::data(weights) + u * DIM, std::data(inputs) + i * DIM);
+    std::chrono::duration<double> one_by_one = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    (*batch)(std::data(weights), NB_UNITS, DIM, std::data(inputs), NB_INPUTS, std::data(results));
+    std::chrono::duration<double> batched = std::chrono::steady_clock::now() - start;
+
+    double max_diff = 0;
+    for(std::size_t k = 0; k < results.size(); ++k)
+      max_diff = std::max(max_diff, std::fabs(results[k] - expected[k]));
+
+    std::cout << op << " : " << NB_INPUTS << " inputs x " << NB_UNITS << " units (dim = " << DIM << ')' << std::endl
+	      << "  one by one : " << one_by_one.count() << "s" << std::endl
+	      << "  batched    : " << batched.count()    << "s" << std::endl
+	      << "  max diff   : " << max_diff << std::endl;
+  }
+
+  if(!update_factory.batch("argmax", {}))
+    std::cout << "argmax has no batched version." << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,166 @@
+#include <cxsom-server.hpp>
+
+// This is used in case of some macros are set. You can remove this
+// lines otherwise... or keep it.
+cxsom::Tick*    cxsom::ticker  = new cxsom::Tick();
+cxsom::Log*     cxsom::logger  = new cxsom::Log();
+cxsom::Monitor* cxsom::monitor = new cxsom::Monitor();
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#define MIN_DURATION .1 // s, per case.
+#define MIN_CALLS    5
+
+struct Case {
+  std::string op;
+  std::string res;
+  std::vector<std::string> args;
+};
+
+// These are the type geometries of the grid.
+std::vector<std::string> contents() {return {"Scalar", "Pos1D", "Pos2D", "Array=16", "Array=128"};}
+std::vector<std::pair<std::string, unsigned int>> shapes() {return {{"Map1D", 100}, {"Map1D", 1000}, {"Map2D", 10}, {"Map2D", 50}};}
+
+std::string map(const std::string& shape, unsigned int side, const std::string& content) {
+  return shape + "<" + content + ">=" + std::to_string(side);
+}
+
+std::vector<Case> cases() {
+  std::vector<Case> res;
+  std::vector<std::string> values = contents();
+  for(auto& [shape, side] : shapes()) {
+    values.push_back(map(shape, side, "Scalar"));
+    values.push_back(map(shape, side, "Array=16"));
+  }
+  for(auto& t : values) res.push_back({"copy", t, {t}});
+  res.push_back({"min", "Scalar", {"Scalar", "Scalar", "Scalar", "Scalar"}});
+  res.push_back({"max", "Scalar", {"Scalar", "Scalar", "Scalar", "Scalar"}});
+
+  for(auto& [shape, side] : shapes()) {
+    std::string pos    = shape == "Map1D" ? "Pos1D" : "Pos2D";
+    std::string scalar = map(shape, side, "Scalar");
+    res.push_back({"average", scalar, {scalar, scalar}}); // Average sums maps of scalars.
+    res.push_back({"merge",   scalar, {scalar, scalar}});
+    for(auto& c : contents()) {
+      std::string weights = map(shape, side, c);
+      res.push_back({"match-triangle", scalar,  {c, weights}});
+      res.push_back({"match-gaussian", scalar,  {c, weights}});
+      res.push_back({"learn-triangle", weights, {c, weights, pos}});
+      res.push_back({"learn-gaussian", weights, {c, weights, pos}});
+      res.push_back({"value-at",       c,       {weights, pos}});
+    }
+    res.push_back({"argmax",             pos, {scalar}});
+    res.push_back({"conv-argmax",        pos, {scalar}});
+    res.push_back({"toward-argmax",      pos, {scalar, pos}});
+    res.push_back({"toward-conv-argmax", pos, {scalar, pos}});
+  }
+
+  res.push_back({"pair",   "Pos2D", {"Pos1D", "Pos1D"}});
+  res.push_back({"first",  "Pos1D", {"Pos2D"}});
+  res.push_back({"second", "Pos1D", {"Pos2D"}});
+  return res;
+}
+
+// Each operation is executed on in-memory instances, whose arguments
+// are ready, so the timing only concerns the computation. The result
+// is set back to busy before each call. The throughput counts all the
+// bytes of the arguments and of the result, so it overestimates the
+// one of value-at, which only reads one weight.
+int main(int argc, char* argv[]) {
+  std::string only;
+  if(argc > 1) only = argv[1];
+
+  cxsom::jobs::UpdateFactory update_factory;
+  cxsom::jobs::fill(update_factory);
+  cxsom::jobs::TypeChecker type_checker;
+  cxsom::jobs::fill(type_checker);
+  cxsom::data::Center center(fs::current_path() / "bench");
+
+  std::map<std::string, std::string> params {{"sigma", ".2"}, {"r", ".2"}, {"alpha", ".1"}, {"beta", ".5"},
+					     {"delta", ".01"}, {"random-bmu", "1"}};
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> uniform(0, 1);
+
+  std::cout << std::left << std::setw(20) << "operation" << std::setw(60) << "types" << std::right
+	    << std::setw(12) << "ns/call" << std::setw(12) << "ns/unit" << std::setw(10) << "GB/s" << std::endl;
+
+  unsigned int case_id = 0;
+  for(auto& c : cases()) {
+    ++case_id;
+    if(only != "" && c.op != only) continue;
+
+    auto res_type = cxsom::type::make(c.res);
+    std::vector<cxsom::type::ref> arg_types;
+    for(auto& a : c.args) arg_types.push_back(cxsom::type::make(a));
+    type_checker(c.op, res_type, arg_types);
+
+    std::string name = std::string("case-") + std::to_string(case_id);
+    cxsom::symbol::Instance res_symb {"res", name, 0};
+    center.check(res_symb.variable, res_type, 1, 0, false, true);
+    cxsom::update::bound_arg res {res_symb, center[res_symb]};
+
+    std::vector<cxsom::update::arg>       args;
+    std::vector<cxsom::update::bound_arg> bound_args;
+    std::size_t nb_bytes = res_type->byte_length();
+    unsigned int arg_id = 0;
+    for(auto& t : arg_types) {
+      cxsom::symbol::Instance arg_symb {"arg", name + "-" + std::to_string(arg_id++), 0};
+      center.check(arg_symb.variable, t, 1, 0, false, true);
+      auto inst = center[arg_symb];
+      inst->set([&gen, &uniform](auto& status, auto&, auto& data) {
+	  auto [begin, end] = data.data_range();
+	  for(auto it = begin; it != end; ++it) *it = uniform(gen);
+	  status = cxsom::data::Availability::Ready;
+	});
+      args.push_back({arg_symb, t});
+      bound_args.push_back({arg_symb, inst});
+      nb_bytes += t->byte_length();
+    }
+
+    auto u = update_factory(center, c.op, {res_symb, res_type}, args, params, gen());
+
+    // The units are the ones of the largest map involved.
+    std::size_t nb_units = 1;
+    for(auto& t : arg_types) if(t->is_Map()) nb_units = std::max<std::size_t>(nb_units, static_cast<const cxsom::type::Map*>(t.get())->size);
+    if(res_type->is_Map()) nb_units = std::max<std::size_t>(nb_units, static_cast<const cxsom::type::Map*>(res_type.get())->size);
+
+    std::chrono::duration<double> elapsed {0};
+    unsigned int nb_calls = 0;
+    bool done = true;
+    while(nb_calls < MIN_CALLS || elapsed.count() < MIN_DURATION) {
+      std::get<1>(res)->set([](auto& status, auto&, auto&) {status = cxsom::data::Availability::Busy;});
+      u->rebind(res, bound_args);
+      auto start = std::chrono::steady_clock::now();
+      auto status = (*u)();
+      elapsed += std::chrono::steady_clock::now() - start;
+      done = done && (status == cxsom::update::Status::Done);
+      ++nb_calls;
+    }
+    u->unbind();
+
+    std::string types = c.res + " <-";
+    for(auto& a : c.args) types += " " + a;
+    double ns = elapsed.count() * 1e9 / nb_calls;
+    std::cout << std::left << std::setw(20) << c.op << std::setw(60) << types << std::right << std::fixed
+	      << std::setw(12) << std::setprecision(1) << ns
+	      << std::setw(12) << std::setprecision(2) << ns / nb_units
+	      << std::setw(10) << std::setprecision(2) << nb_bytes / ns;
+    if(!done) std::cout << "  (not done)";
+    std::cout << std::endl;
+  }
+
+  std::cout << std::endl
+	    << "Execute : rm -rf bench" << std::endl
+	    << std::endl;
+  return 0;
+}
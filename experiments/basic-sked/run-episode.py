@@ -15,8 +15,8 @@ if len(sys.argv) != 6:
 root_dir        = sys.argv[1]
 nb_interactions = int(sys.argv[2])
 hostname        = sys.argv[3]
-port            = int(sys.argv[4])
-xrsw_port       = int(sys.argv[5])
+port            = sys.argv[4]
+xrsw_port       = sys.argv[5]
 
 def ping():
     if cx.client.ping(hostname, port):
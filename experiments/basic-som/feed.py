@@ -56,7 +56,7 @@ with cx.variable.Realize(cx.variable.path_from(root_dir, 'in', 'xi')) as xi:
 # unlock computation.
 if len(sys.argv) == 5:
     hostname  = sys.argv[3]
-    port      = int(sys.argv[4])
+    port      = sys.argv[4]
     print('Sending "ping" to {}:{}'.format(hostname, port))
     if cx.client.ping(hostname, port):
         print('Something went wrong.')
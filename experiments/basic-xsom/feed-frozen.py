@@ -13,7 +13,7 @@ if len(sys.argv) < 6:
     
 root_dir = sys.argv[1]
 hostname = sys.argv[2]
-port     = int(sys.argv[3])
+port     = sys.argv[3]
 timeline = sys.argv[4]
 mode     = sys.argv[5]
 
@@ -13,32 +13,35 @@ if len(sys.argv) < 5:
     
 root_dir = sys.argv[1]
 hostname = sys.argv[2]
-port     = int(sys.argv[3])
+port     = sys.argv[3]
 mode     = sys.argv[4]
 
 x_var_path = cx.variable.path_from(root_dir, 'in', 'X')
 y_var_path = cx.variable.path_from(root_dir, 'in', 'Y')
 
-# We feed the inputs buffers... but not beyond.
+# We feed the inputs buffers... but not beyond. The processor writes
+# the inputs, so that the timesteps waiting for them are computed.
 with cx.variable.Realize(x_var_path) as X:
-    with cx.variable.Realize(y_var_path) as Y:
-        r = X.time_range()
-        if r is not None:
-            tmax = r[1]
-            if tmax >= X.file_size - 1:
-                nb_to_write = 0
-                print()
-                print('The input buffers are full, no further feeding is performed.')
-                print()
-            else:
-                nb_to_write = X.file_size - 1 - tmax
-        else:
-            nb_to_write = X.file_size
-        for _ in range(nb_to_write):
-            x, y = sample.get(np.random.random(), mode)
-            X += x
-            Y += y
-            
-print('Sending "ping" to {}:{}'.format(hostname, port))
-if cx.client.ping(hostname, port):
-    print('Something went wrong.')
+    r = X.time_range()
+    file_size = X.file_size
+if r is not None:
+    tmax = r[1]
+    if tmax >= file_size - 1:
+        nb_to_write = 0
+        print()
+        print('The input buffers are full, no further feeding is performed.')
+        print()
+    else:
+        nb_to_write = file_size - 1 - tmax
+    first_at = tmax + 1
+else:
+    nb_to_write = file_size
+    first_at = 0
+
+if nb_to_write > 0:
+    xs, ys = zip(*[sample.get(np.random.random(), mode) for _ in range(nb_to_write)])
+    print('Feeding {} inputs to {}:{}'.format(nb_to_write, hostname, port))
+    for name, values in [('X', xs), ('Y', ys)]:
+        error = cx.client.feed(hostname, port, 'in', name, first_at, values)
+        if error is not None:
+            print('Something went wrong : {}'.format(error))
@@ -14,7 +14,7 @@ if len(sys.argv) < 7:
 
 root_dir = sys.argv[1]
 hostname = sys.argv[2]
-port     = int(sys.argv[3])
+port     = sys.argv[3]
 timeline = sys.argv[4]
 u        = float(sys.argv[5])
 shape    = sys.argv[6]
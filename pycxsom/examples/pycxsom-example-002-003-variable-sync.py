@@ -32,7 +32,7 @@ if mode == 'wait':
     with cx.variable.Realize(varpath) as x :
         x.sync_init() # we record the current time, from which we wait for a modification.
         print('waiting for new value...')
-        x.wait_next(sleep_duration=.01) # We scan every 10ms to check for a value change.
+        x.wait_next() # File change notifications are used, or a 100ms polling if not available.
         print('... got {} !'.format(x[-1]))
 
 class Listener:
@@ -46,5 +46,5 @@ if mode == 'listen':
     with cx.variable.Realize(varpath) as x :
         x.sync_init() # we record the current time, from which we wait the first.
         print('Listening...')
-        x.listen(l.on_new_value, sleep_duration=.01) # We scan every 10ms to check for a value change.
+        x.listen(l.on_new_value) # l.on_new_value is called each time a new value is written.
     
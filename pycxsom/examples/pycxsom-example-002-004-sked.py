@@ -24,7 +24,7 @@ if len(sys.argv) != 5:
 mode     = sys.argv[1]
 duration = float(sys.argv[2])
 hostname = sys.argv[3]
-port     = int(sys.argv[4])
+port     = sys.argv[4]
 
 if mode == 'read':
     locker = cx.sked.read(hostname, port)
@@ -10,7 +10,7 @@ if len(sys.argv) < 3:
     sys.exit(0)
 
 hostname = sys.argv[1]
-port     = int(sys.argv[2])
+port     = sys.argv[2]
 
 error = cx.client.clear(hostname, port)
 if error :
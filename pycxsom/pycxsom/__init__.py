@@ -4,5 +4,7 @@ from . import variable
 from . import sked
 from . import tkviewer
 from . import client
+from . import notify
+from . import archive
 from . import plot
 from . import monitor
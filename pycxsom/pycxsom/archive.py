@@ -0,0 +1,85 @@
+import os
+import os.path
+import struct
+import numpy as np
+
+from . import typing
+from . import error
+from . import variable
+
+# See cxsomArchive.hpp for the .vca layout.
+ARCHIVE_VERSION                = 1
+OFFSET_VERSION_IN_ARCHIVE      = variable.LENGTH_TYPE_IN_FILE
+OFFSET_HEADER_IN_ARCHIVE       = 128
+
+def path_from(archive_root, timeline, varname):
+    varname += '.vca'
+    names = varname.split('\\')
+    return os.path.join(archive_root, timeline, os.path.join(*names))
+
+class Archive:
+    """
+    Read-only access to a .vca columnar archive, built by cxsom-archive.
+    """
+    def __init__(self, path):
+        self.path = path
+        with open(path, 'rb') as f:
+            s = f.read(variable.LENGTH_TYPE_IN_FILE)
+            self.datatype = typing.make(s[:s.index(10)].decode('ascii'))
+            version, self.first_time, self.nb_times, self.byte_length, ready_pos, payload_pos = struct.unpack('6Q', f.read(6 * variable.UINT_LENGTH))
+        if version != ARCHIVE_VERSION:
+            raise error.Parse(path, 'archive version {}, {} expected'.format(version, ARCHIVE_VERSION))
+        if self.nb_times == 0:
+            self.ready   = np.empty(0, dtype=bool)
+            self.payload = np.empty((0,) + self.private_shape())
+            return
+        bitmap = np.memmap(path, dtype=np.uint8, mode='r', offset=ready_pos, shape=((self.nb_times + 7) // 8,))
+        self.ready = np.unpackbits(bitmap, bitorder='little')[:self.nb_times].astype(bool)
+        self.payload = np.memmap(path, dtype='<f8', mode='r', offset=payload_pos,
+                                 shape=(self.nb_times,) + self.private_shape())
+
+    def private_shape(self):
+        shape = self.datatype.shape()
+        if shape == (1,):
+            return ()
+        return shape
+
+    def time_range(self):
+        """
+        returns the range of archived times as a tuple [tmin, tmax], or None.
+        """
+        if self.nb_times == 0:
+            return None
+        return (self.first_time, self.first_time + self.nb_times - 1)
+
+    def private_index_of(self, at):
+        if at >= 0:
+            return at
+        if self.nb_times + at >= 0:
+            return self.first_time + self.nb_times + at
+        raise error.Index(at)
+
+    def __getitem__(self, at):
+        at = self.private_index_of(at)
+        if self.nb_times == 0 or at >= self.first_time + self.nb_times:
+            raise error.Busy()
+        if at < self.first_time:
+            raise error.Forgotten()
+        i = at - self.first_time
+        if not self.ready[i]:
+            raise error.Busy()
+        return self.payload[i]
+
+    def batch(self, first=None, last=None):
+        """
+        Same as variable.Realize.batch. The returned values are always views of the mapped archive.
+        """
+        r = self.time_range()
+        if r is None:
+            return (np.empty(0, dtype=np.uint64), self.ready, self.payload)
+        first = r[0] if first is None else max(self.private_index_of(first), r[0])
+        last  = r[1] if last  is None else min(self.private_index_of(last),  r[1])
+        if first > last:
+            return (np.empty(0, dtype=np.uint64), self.ready[:0], self.payload[:0])
+        b, e = first - self.first_time, last - self.first_time + 1
+        return (np.arange(first, last + 1, dtype=np.uint64), self.ready[b:e], self.payload[b:e])
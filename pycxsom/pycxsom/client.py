@@ -1,12 +1,26 @@
 import socket
+import numpy as np
+
+def _connect(hostname, port):
+    """
+    returns a socket connected to hostname:port, or to the local
+    socket file if port is 'unix:/path' (hostname is ignored then).
+    """
+    port = str(port)
+    if port.startswith('unix:'):
+        s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        s.connect(port[len('unix:'):])
+    else:
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.connect((hostname, int(port)))
+    return s
 
 def ping(hostname, port):
     """
     returns None is ping has been sent, an error string otherwise.
     """
     line = 'Connection error'
-    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
-        s.connect((hostname, port))
+    with _connect(hostname, port) as s:
         s.sendall(b'ping\n')
         line = s.recv(1024).decode("utf-8").split('\n')[0]
     if line == 'ok':
@@ -18,8 +32,7 @@ def clear(hostname, port):
     returns None is clear has been sent, an error string otherwise.
     """
     line = 'Connection error'
-    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
-        s.connect((hostname, port))
+    with _connect(hostname, port) as s:
         s.sendall(b'clear\n')
         line = s.recv(1024).decode("utf-8").split('\n')[0]
     if line == 'ok':
@@ -27,3 +40,157 @@ def clear(hostname, port):
     return line
     
 
+def trace(hostname, port, path=None):
+    """
+    starts tracing if path is None, stops it and makes the processor
+    write the trace in path (Chrome trace format) otherwise. returns
+    None on success, an error string otherwise.
+    """
+    line = 'Connection error'
+    with _connect(hostname, port) as s:
+        if path is None:
+            s.sendall(b'trace on\n')
+        else:
+            s.sendall('trace off {}\n'.format(path).encode('utf-8'))
+        line = s.recv(1024).decode("utf-8").split('\n')[0]
+    if line == 'ok':
+        return None
+    return line
+
+def record(hostname, port, path=None):
+    """
+    makes the processor record the received commands in path, or
+    stops the recording if path is None (see cxsom-replay). returns
+    None on success, an error string otherwise.
+    """
+    line = 'Connection error'
+    with _connect(hostname, port) as s:
+        if path is None:
+            s.sendall(b'record off\n')
+        else:
+            s.sendall('record on {}\n'.format(path).encode('utf-8'))
+        line = s.recv(1024).decode("utf-8").split('\n')[0]
+    if line == 'ok':
+        return None
+    return line
+
+def feed(hostname, port, timeline, name, first_at, values):
+    """
+    makes the processor set the instances of the variable from
+    first_at with values, the first dimension of values being the
+    instances. The timesteps waiting for them are computed, no ping
+    is needed. returns None on success, an error string otherwise.
+    """
+    values = np.ascontiguousarray(values, dtype=np.float64)
+    count = values.shape[0] if values.ndim > 0 else 1
+    payload = values.tobytes()
+    line = 'Connection error'
+    with _connect(hostname, port) as s:
+        s.sendall('feed {} {} {} {} {}\n'.format(timeline, name, first_at, count, len(payload)).encode('utf-8') + payload)
+        line = s.makefile('r', encoding='utf-8').readline().rstrip('\n')
+    if line == 'ok':
+        return None
+    return line
+
+def notify(hostname, port, timeline, name, from_at=None, to_at=None):
+    """
+    tells the processor that the instances of the variable (in
+    [from_at, to_at] if given) may have been written in its file. As
+    ping, but only the timesteps waiting for them are reconsidered.
+    returns None on success, an error string otherwise.
+    """
+    line = 'Connection error'
+    with _connect(hostname, port) as s:
+        if from_at is None:
+            s.sendall('notify {} {}\n'.format(timeline, name).encode('utf-8'))
+        else:
+            s.sendall('notify {} {} {} {}\n'.format(timeline, name, from_at, to_at).encode('utf-8'))
+        line = s.makefile('r', encoding='utf-8').readline().rstrip('\n')
+    if line == 'ok':
+        return None
+    return line
+
+def watch(hostname, port, timeline, name, on=True):
+    """
+    makes the processor watch the file of the variable (or stop
+    watching it), so that writing in it is notified without any
+    further message. returns None on success, an error string
+    otherwise.
+    """
+    line = 'Connection error'
+    with _connect(hostname, port) as s:
+        s.sendall('watch {} {} {}\n'.format('on' if on else 'off', timeline, name).encode('utf-8'))
+        line = s.makefile('r', encoding='utf-8').readline().rstrip('\n')
+    if line == 'ok':
+        return None
+    return line
+
+def subscribe(hostname, port, timeline=None, name=None, payload=False):
+    """
+    generates (timeline, name, at, value) for each instance that gets
+    ready in the processor, from the timeline (or the variable) if
+    given. value is None, unless payload is True, where it is the
+    array of the doubles of the instance. If the processor had to
+    drop events since this generator is too slow, None is generated
+    instead of them. An error string is raised as a ValueError.
+    """
+    with _connect(hostname, port) as s:
+        request = ['subscribe', 'payload' if payload else 'notify']
+        if timeline is not None:
+            request.append(timeline)
+            if name is not None:
+                request.append(name)
+        s.sendall((' '.join(request) + '\n').encode('utf-8'))
+        f = s.makefile('rb')
+        line = f.readline().decode('utf-8').rstrip('\n')
+        if line != 'ok':
+            raise ValueError(line)
+        while True:
+            words = f.readline().decode('utf-8').split()
+            if len(words) == 0:
+                return
+            if words[0] == 'dropped':
+                yield None
+                continue
+            value = None
+            if payload:
+                value = np.frombuffer(f.read(int(words[4])), dtype=np.float64)
+            yield (words[1], words[2], int(words[3]), value)
+
+def stats(hostname, port):
+    """
+    returns the statistics of the processor as a dictionary, an
+    error string otherwise. Each statistic line of the processor is
+    found from its first word (e.g. 'operation'), as a list of
+    dictionaries, e.g. {'operation': [{'name': 'average', 'tasks':
+    10, 'time': 0.001, 'histogram': [...]}, ...], ...}.
+    """
+    line = 'Connection error'
+    with _connect(hostname, port) as s:
+        s.sendall(b'stats\n')
+        f = s.makefile('r', encoding='utf-8')
+        line = f.readline().rstrip('\n')
+        answer = line.split()
+        if len(answer) != 2 or answer[0] != 'ok':
+            return line
+        res = {}
+        for _ in range(int(answer[1])):
+            words = f.readline().split()
+            kind, words = words[0], words[1:]
+            info = {}
+            if kind == 'operation':
+                i = words.index('histogram')
+                info['histogram'] = [int(w) for w in words[i+1:]]
+                words = words[:i]
+            if len(words) % 2 == 1:
+                info['name'], words = words[0], words[1:]
+            for key, value in zip(words[0::2], words[1::2]):
+                try:
+                    info[key] = int(value)
+                except ValueError:
+                    info[key] = float(value)
+            if kind == 'uptime':
+                res[kind] = float(info['name'])
+            else:
+                res.setdefault(kind, []).append(info)
+    return res
@@ -0,0 +1,277 @@
+import os
+import os.path
+import time
+import struct
+import select
+import ctypes
+import ctypes.util
+
+from . import variable
+
+# inotify(7) constants.
+IN_MODIFY      = 0x00000002
+IN_ATTRIB      = 0x00000004
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVE_SELF   = 0x00000800
+IN_DELETE_SELF = 0x00000400
+IN_IGNORED     = 0x00008000
+IN_NONBLOCK    = os.O_NONBLOCK
+IN_CLOEXEC     = 0o2000000
+
+WATCH_MASK     = IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF
+EVENT_HEADER   = struct.Struct('iIII')
+READ_LENGTH    = 65536
+
+def _load_libc():
+    try:
+        libc = ctypes.CDLL(ctypes.util.find_library('c') or 'libc.so.6', use_errno=True)
+    except OSError:
+        return None
+    if not hasattr(libc, 'inotify_init1'):
+        return None
+    libc.inotify_init1.argtypes     = [ctypes.c_int]
+    libc.inotify_add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+    libc.inotify_rm_watch.argtypes  = [ctypes.c_int, ctypes.c_int]
+    return libc
+
+_libc = _load_libc()
+
+def inotify_available():
+    """
+    returns True if file change notifications are supported by the system.
+    """
+    return _libc is not None
+
+
+class Inotify:
+    """
+    Minimal ctypes binding to the linux inotify API.
+    """
+    def __init__(self):
+        if _libc is None:
+            raise OSError('inotify is not available on this system')
+        self.fd = _libc.inotify_init1(IN_NONBLOCK | IN_CLOEXEC)
+        if self.fd < 0:
+            errno = ctypes.get_errno()
+            raise OSError(errno, os.strerror(errno))
+        self.poller = select.poll()
+        self.poller.register(self.fd, select.POLLIN)
+
+    def add(self, path):
+        """
+        returns the watch descriptor, or None if the file cannot be watched (yet).
+        """
+        wd = _libc.inotify_add_watch(self.fd, os.fsencode(path), WATCH_MASK)
+        if wd < 0:
+            return None
+        return wd
+
+    def remove(self, wd):
+        _libc.inotify_rm_watch(self.fd, wd)
+
+    def read(self, timeout):
+        """
+        timeout : in seconds, None means forever.
+        returns a list of (wd, mask) pairs, empty if timeout has elapsed.
+        """
+        if timeout is not None:
+            timeout = max(0, int(timeout * 1000))
+        if not self.poller.poll(timeout):
+            return []
+        try:
+            buf = os.read(self.fd, READ_LENGTH)
+        except BlockingIOError:
+            return []
+        res = []
+        pos = 0
+        while pos + EVENT_HEADER.size <= len(buf):
+            wd, mask, _, name_length = EVENT_HEADER.unpack_from(buf, pos)
+            res.append((wd, mask))
+            pos += EVENT_HEADER.size + name_length
+        return res
+
+    def close(self):
+        if self.fd is not None:
+            os.close(self.fd)
+            self.fd = None
+
+
+class Watcher:
+    """
+    This waits for the highest time of a set of variables to change,
+    without rereading the .var headers periodically when inotify is
+    available. Otherwise, it falls back to polling every
+    sleep_duration seconds.
+    """
+    def __init__(self, sleep_duration=.1, use_inotify=True):
+        self.sleep_duration = sleep_duration
+        self.inotify = None
+        if use_inotify and inotify_available():
+            try:
+                self.inotify = Inotify()
+            except OSError:
+                pass # e.g. fs.inotify.max_user_instances is reached, we poll.
+        self.watched = {} # path -> [realize, highest_time, callbacks, wd, opened here]
+        self.wds     = {} # wd -> path
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, exc_traceback):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def close(self):
+        if self.inotify is not None:
+            self.inotify.close()
+            self.inotify = None
+        self.watched = {}
+        self.wds     = {}
+
+    def add(self, var, callback=None):
+        """
+        var : a Realize instance or a .var path.
+        callback : if not None, callback(realize) is called by listen() each time the highest time changes.
+        returns the Realize instance.
+        """
+        path = var.path if isinstance(var, variable.Realize) else var
+        entry = self.watched.get(path)
+        if entry is None:
+            if isinstance(var, variable.Realize):
+                v = var
+            else:
+                v = variable.Realize(var)
+                v.open()
+            entry = [v, None, [], None, v is not var]
+            self.watched[v.path] = entry
+            self.private_watch(entry)
+            entry[1] = self.private_highest_time(entry)
+        if callback is not None:
+            entry[2].append(callback)
+        return entry[0]
+
+    def remove(self, var):
+        path = var.path if isinstance(var, variable.Realize) else var
+        entry = self.watched.pop(path, None)
+        if entry is None:
+            return
+        if entry[3] is not None:
+            self.wds.pop(entry[3], None)
+            if self.inotify is not None:
+                self.inotify.remove(entry[3])
+        if entry[4]:
+            entry[0].close()
+
+    def private_watch(self, entry):
+        if self.inotify is None or entry[3] is not None:
+            return
+        wd = self.inotify.add(entry[0].path)
+        if wd is not None:
+            entry[3] = wd
+            self.wds[wd] = entry[0].path
+
+    def private_highest_time(self, entry):
+        try:
+            with open(entry[0].path, 'rb') as f:
+                f.seek(variable.OFFSET_HIGHEST_TIME_IN_FILE, os.SEEK_SET)
+                return struct.unpack('Q', f.read(variable.UINT_LENGTH))[0]
+        except (OSError, struct.error):
+            return None
+
+    def private_check(self, entries):
+        changed = []
+        for entry in entries:
+            self.private_watch(entry) # The file may have been recreated.
+            h = self.private_highest_time(entry)
+            if h != entry[1]:
+                entry[1] = h
+                if h is not None and h != variable.no_time:
+                    entry[0].update()
+                    changed.append(entry[0])
+        return changed
+
+    def wait(self, timeout=None):
+        """
+        Blocks until the highest time of some watched variables changes,
+        or timeout (in seconds, None means forever) elapses.
+        returns the list of the Realize instances that have changed,
+        empty if timeout has elapsed.
+        """
+        deadline = None if timeout is None else time.monotonic() + timeout
+        while True:
+            remaining = None if deadline is None else max(0, deadline - time.monotonic())
+            if self.inotify is None:
+                if remaining is None:
+                    time.sleep(self.sleep_duration)
+                else:
+                    time.sleep(min(self.sleep_duration, remaining))
+                changed = self.private_check(self.watched.values())
+            else:
+                # Files that could not be watched yet are polled.
+                unwatched = [e for e in self.watched.values() if e[3] is None]
+                if unwatched and (remaining is None or remaining > self.sleep_duration):
+                    remaining = self.sleep_duration
+                events = self.inotify.read(remaining)
+                paths = set()
+                for wd, mask in events:
+                    path = self.wds.get(wd)
+                    if path is None:
+                        continue
+                    if mask & IN_IGNORED:
+                        del self.wds[wd]
+                        if path in self.watched:
+                            self.watched[path][3] = None
+                    paths.add(path)
+                entries = [self.watched[p] for p in paths if p in self.watched]
+                changed = self.private_check(entries + [e for e in unwatched if e not in entries])
+            if changed:
+                return changed
+            if deadline is not None and time.monotonic() >= deadline:
+                return []
+
+    def listen(self):
+        """
+        Loops forever, calling the callbacks of the variables whose highest time changes.
+        """
+        while True:
+            for v in self.wait():
+                for callback in self.watched[v.path][2]:
+                    callback(v)
+
+
+# The Realize instances waiting for their own changes share this
+# watcher, so that a single inotify instance is used by the process
+# (their number is limited by fs.inotify.max_user_instances, 128 by
+# default).
+_shared       = None
+_shared_users = {} # path -> number of watch calls not released yet.
+
+def watch(path, sleep_duration=.1):
+    """
+    returns the watcher shared in the process, which now watches path
+    (a .var file). Its wait() returns when any of its variables
+    changes. Call unwatch(path) when done.
+    """
+    global _shared
+    if _shared is None:
+        _shared = Watcher(sleep_duration)
+    _shared.sleep_duration = sleep_duration
+    if _shared_users.get(path, 0) == 0:
+        _shared.add(path)
+    _shared_users[path] = _shared_users.get(path, 0) + 1
+    return _shared
+
+def unwatch(path):
+    """
+    releases a former watch(path).
+    """
+    nb = _shared_users.get(path, 0)
+    if nb == 0:
+        return
+    if nb == 1:
+        del _shared_users[path]
+        _shared.remove(path)
+    else:
+        _shared_users[path] = nb - 1
@@ -1,12 +1,11 @@
-import socket
+from . import client
 
 
 class _locker:
     def __init__(self, server_tag, client_tag, hostname, port):
         self.server_tag = server_tag
         self.client_tag = client_tag+'\n'
-        self.s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        self.s.connect((hostname, port))
+        self.s = client._connect(hostname, port)
         
     def _interact(self):
         self.s.sendall(bytes(self.client_tag, encoding='utf-8'))
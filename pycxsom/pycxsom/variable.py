@@ -2,9 +2,11 @@ import os
 import os.path
 import struct
 import time
+import numpy as np
 
 from . import typing
 from . import error
+from . import notify
 
 UINT_LENGTH                  = 8
 LENGTH_TYPE_IN_FILE          = 64
@@ -20,6 +22,13 @@ OFFSET_HIGHEST_TIME_IN_FILE  = OFFSET_FILE_SIZE_IN_FILE     + LENGTH_FILE_SIZE_I
 OFFSET_NEXT_FREE_POS_IN_FILE = OFFSET_HIGHEST_TIME_IN_FILE  + LENGTH_HIGHEST_TIME_IN_FILE 
 OFFSET_HEADER_IN_FILE        = OFFSET_NEXT_FREE_POS_IN_FILE + LENGTH_NEXT_FREE_POS_IN_FILE
 
+# The last byte of the type area tells the slot layout (see cxsomVariable.hpp).
+OFFSET_LAYOUT_IN_FILE        = OFFSET_TYPE_IN_FILE + LENGTH_TYPE_IN_FILE - 1
+OFFSET_ALIGNED_HEADER_IN_FILE = 128
+SLOT_ALIGNMENT               = 64
+LAYOUT_PACKED                = 0 # slots are [ready byte | payload]
+LAYOUT_ALIGNED               = 1 # slots are [payload | ready byte | padding]
+
 no_time = struct.unpack('Q', b'\xff\xff\xff\xff\xff\xff\xff\xff')[0]
 
 def path_from(root_dir, timeline, varname):
@@ -47,12 +56,13 @@ def names_from(varpath):
     
     
 class Realize:
-    def __init__(self, path, t = None, cache_size = None, file_size = None):
+    def __init__(self, path, t = None, cache_size = None, file_size = None, aligned = False):
         """
         path : the file path (.var) of the variable.
         type : If not None, it is used to create an empty variable if the .var file does not exist yet.
         cache_size : If not none, it sets the cache size (used at server side) if the .var file does not exist yet.
         file_size : If not none, this sets the file buffer size if the .var file does not exist yet.
+        aligned : If True, the file is created with 64-byte aligned slots. The layout of existing files is detected.
         """
         self.path = path
         if(os.path.exists(path)):
@@ -62,7 +72,10 @@ class Realize:
                 if b == 10 :
                     break
             self.datatype = typing.make(s[:idx].decode('ascii'))
+            self.layout = s[OFFSET_LAYOUT_IN_FILE]
             self.datafile.close()
+            if self.layout not in (LAYOUT_PACKED, LAYOUT_ALIGNED):
+                raise error.Parse(self.path, 'unknown slot layout {}'.format(self.layout))
             if (t is not None) and (str(t) != str(self.datatype)):
                 raise error.Typing(t, "Existing variable {} as already a type {}".format(self.path, self.datatype))
             if cache_size is not None:
@@ -83,15 +96,20 @@ class Realize:
                 os.makedirs(os.path.dirname(path))
             self.datafile = open(path, 'wb')
             self.datatype = t
+            self.layout = LAYOUT_ALIGNED if aligned else LAYOUT_PACKED
             self.datafile.write(bytearray(str(self.datatype)+"\n", 'ascii'))
             pad = LENGTH_TYPE_IN_FILE - (len(str(self.datatype))+1)
-            self.datafile.write(bytes(pad))
+            self.datafile.write(bytes(pad - 1))
+            self.datafile.write(struct.pack('B', self.layout))
             self.datafile.write(struct.pack('Q', cache_size))
             self.datafile.write(struct.pack('Q', file_size))
             self.datafile.write(bytes(b'\xff\xff\xff\xff\xff\xff\xff\xff'))
             self.datafile.write(bytes(b'\x00\x00\x00\x00\x00\x00\x00\x00'))
+            if self.layout == LAYOUT_ALIGNED:
+                self.datafile.write(bytes(OFFSET_ALIGNED_HEADER_IN_FILE - OFFSET_HEADER_IN_FILE))
             self.datafile.close()
         self.datafile = None
+        self.watcher  = None
 
 
         
@@ -109,13 +127,25 @@ class Realize:
         self.close()
         self.datafile      = open(self.path, 'rb+')
         self.data_length   = self.datatype.length()
-        self.slot_length   = self.data_length + 1
+        if self.layout == LAYOUT_PACKED:
+            self.data_offset    = OFFSET_HEADER_IN_FILE
+            self.ready_offset   = 0
+            self.payload_offset = 1
+            self.slot_length    = self.data_length + 1
+        else:
+            self.data_offset    = OFFSET_ALIGNED_HEADER_IN_FILE
+            self.ready_offset   = self.data_length
+            self.payload_offset = 0
+            self.slot_length    = ((self.data_length + 1 + SLOT_ALIGNMENT - 1) // SLOT_ALIGNMENT) * SLOT_ALIGNMENT
         self.private_update()
         
     def close(self):
         if self.datafile != None:
             self.datafile.close()
             self.datafile = None
+        if self.watcher is not None:
+            notify.unwatch(self.path)
+            self.watcher = None
 
     def __enter__(self):
         self.open()
@@ -133,7 +163,8 @@ class Realize:
         can be usefull if somebody else changes the file while it is
         beeing handled.
         """
-        self.close()
+        if self.datafile != None:
+            self.datafile.close() # Not self.close(), which would stop watching the file.
         self.datafile = open(self.path, 'rb+')
         self.private_update()
         
@@ -178,7 +209,21 @@ class Realize:
         self.private_seek_htma(self.highest_time - at)
         
     def private_seek_htma(self, highest_time_minus_at):
-        self.datafile.seek(OFFSET_HEADER_IN_FILE + self.private_pos_in_past(highest_time_minus_at) * self.slot_length, os.SEEK_SET)
+        self.datafile.seek(self.data_offset + self.private_pos_in_past(highest_time_minus_at) * self.slot_length, os.SEEK_SET)
+
+    def private_is_ready(self, slot_pos):
+        self.datafile.seek(slot_pos + self.ready_offset, os.SEEK_SET)
+        return struct.unpack('?', self.datafile.read(1))[0]
+
+    def private_write_slot(self, value):
+        # This writes a slot at the current file position.
+        if self.layout == LAYOUT_PACKED:
+            self.datafile.write(struct.pack('?', True))
+            self.datafile.write(self.datatype.pack(value))
+        else:
+            self.datafile.write(self.datatype.pack(value))
+            self.datafile.write(struct.pack('?', True))
+            self.datafile.write(bytes(self.slot_length - self.data_length - 1))
         
 
     def __getitem__(self, at):
@@ -198,13 +243,55 @@ class Realize:
         highest_time_minus_at = self.highest_time - at
         if self.private_is_past_in_buffer(highest_time_minus_at):
             self.private_seek_htma(highest_time_minus_at)
-            if struct.unpack('?', self.datafile.read(1))[0]:
+            pos = self.datafile.tell()
+            if self.private_is_ready(pos):
+                self.datafile.seek(pos + self.payload_offset, os.SEEK_SET)
                 return self.datatype.unpack(self.datafile.read(self.data_length))
             else:
                 raise error.Busy()
         else:
             raise error.Forgotten()
 
+    def private_slot_dtype(self):
+        shape = self.datatype.shape()
+        if shape == (1,):
+            payload = '<f8'
+        else:
+            payload = ('<f8', shape)
+        return np.dtype({'names'   : ['ready', 'payload'],
+                         'formats' : ['?', payload],
+                         'offsets' : [self.ready_offset, self.payload_offset],
+                         'itemsize': self.slot_length})
+        
+    def batch(self, first=None, last=None):
+        """
+        Reads all the instances in [first, last] at once. Indices can be
+        negative, as for v[at], and they default to the stored time
+        range. It returns (times, ready_mask, values) numpy arrays, where
+        values[i] is meaningless when ready_mask[i] is False. Times out
+        of the file history are skipped. The arrays are read-only views
+        of the mapped file, unless the range wraps around the end of the
+        circular buffer, where they are copies.
+        """
+        dtype = self.private_slot_dtype()
+        empty = (np.empty(0, dtype=np.uint64), np.empty(0, dtype=bool), np.empty((0,) + dtype['payload'].shape))
+        r = self.time_range()
+        if r is None:
+            return empty
+        first = r[0] if first is None else max(self.private_index_of(first), r[0])
+        last  = r[1] if last  is None else min(self.private_index_of(last),  r[1])
+        if first > last:
+            return empty
+        nb_slots = min(self.file_size, (os.path.getsize(self.path) - self.data_offset) // dtype.itemsize)
+        slots = np.memmap(self.path, dtype=dtype, mode='r', offset=self.data_offset, shape=(nb_slots,))
+        begin = self.private_pos_in_past(self.highest_time - first)
+        end   = self.private_pos_in_past(self.highest_time - last) + 1
+        if begin < end:
+            s = slots[begin:end]
+        else:
+            s = np.concatenate((slots[begin:], slots[:end]))
+        return (np.arange(first, last + 1, dtype=np.uint64), s['ready'], s['payload'])
+
     def __setitem__(self, at, value):
         """
         Sets the variable content. It may raise an Ready exception if the 
@@ -217,19 +304,18 @@ class Realize:
             raise error.Forgotten()
         
         if self.highest_time == no_time:
-            self.datafile.seek(OFFSET_HEADER_IN_FILE, os.SEEK_SET)
+            self.datafile.seek(self.data_offset, os.SEEK_SET)
             null_slot = b'\0' * self.slot_length
             if at > self.file_size:
                 for i in range(self.file_size):
                     self.datafile.write(null_slot)
-                self.datafile.seek(OFFSET_HEADER_IN_FILE, os.SEEK_SET)
+                self.datafile.seek(self.data_offset, os.SEEK_SET)
                 self.next_free_pos = self.private_next_pos(0)
             else:
                 for i in range(at):
                     self.datafile.write(null_slot)
                 self.next_free_pos = self.private_next_pos(at)
-            self.datafile.write(struct.pack('?', True))
-            self.datafile.write(self.datatype.pack(value))
+            self.private_write_slot(value)
             self.highest_time = at
             self.datafile.seek(OFFSET_HIGHEST_TIME_IN_FILE, os.SEEK_SET)
             self.datafile.write(struct.pack('Q', at))
@@ -243,11 +329,10 @@ class Realize:
             if self.private_is_past_in_buffer(htma):
                 self.private_seek_htma(htma)
                 pos = self.datafile.tell()
-                if struct.unpack('?', self.datafile.read(1))[0]:
+                if self.private_is_ready(pos):
                     raise error.Ready()
                 self.datafile.seek(pos, os.SEEK_SET)
-                self.datafile.write(struct.pack('?', True))
-                self.datafile.write(self.datatype.pack(value))
+                self.private_write_slot(value)
                 self.datafile.flush()
                 return
             else:
@@ -256,26 +341,25 @@ class Realize:
         nb_zeros  = at - 1 - self.highest_time
         null_slot = b'\0' * self.slot_length
         if nb_zeros > self.file_size:
-            self.datafile.seek(OFFSET_HEADER_IN_FILE, os.SEEK_SET)
+            self.datafile.seek(self.data_offset, os.SEEK_SET)
             for i in range(self.file_size):
                 self.datafile.write(null_slot)
-            self.datafile.seek(OFFSET_HEADER_IN_FILE, os.SEEK_SET)
+            self.datafile.seek(self.data_offset, os.SEEK_SET)
             self.next_free_pos = self.private_next_pos(0)
         else:
             data_pos      = self.next_free_pos + nb_zeros
             upper_bound   = min(self.file_size, data_pos)
             nb_to_the_end = upper_bound - self.next_free_pos
-            self.datafile.seek(OFFSET_HEADER_IN_FILE + self.next_free_pos * self.slot_length, os.SEEK_SET)
+            self.datafile.seek(self.data_offset + self.next_free_pos * self.slot_length, os.SEEK_SET)
             for i in range(nb_to_the_end):
                 self.datafile.write(null_slot)
             if data_pos >= self.file_size:
                 data_pos = data_pos - self.file_size
-                self.datafile.seek(OFFSET_HEADER_IN_FILE, os.SEEK_SET)
+                self.datafile.seek(self.data_offset, os.SEEK_SET)
                 for i in range(data_pos):
                     self.datafile.write(null_slot)
             self.next_free_pos = self.private_next_pos(data_pos)
-        self.datafile.write(struct.pack('?', True))
-        self.datafile.write(self.datatype.pack(value))
+        self.private_write_slot(value)
         self.highest_time = at
         self.datafile.seek(OFFSET_HIGHEST_TIME_IN_FILE, os.SEEK_SET)
         self.datafile.write(struct.pack('Q', at))
@@ -293,38 +377,53 @@ class Realize:
             self[0]      = value
         return self
 
-    def sync_init(self):
-        self.update()
-        self.sync0 = self.time_range()
+    def private_watcher(self, sleep_duration):
+        if self.watcher is None:
+            self.watcher = notify.watch(self.path, sleep_duration)
+        self.watcher.sleep_duration = sleep_duration
+        return self.watcher
 
-    def try_wait_next(self, sleep_duration=.1):
+    def private_changed(self):
         self.update()
         dd = self.time_range()
         if dd == self.sync0:
-            time.sleep(sleep_duration)
-            self.update()
-            dd = self.time_range()
-            if dd == self.sync0:
-                return False
+            return False
         self.sync0 = dd
         return True
         
+    def sync_init(self):
+        self.update()
+        self.sync0 = self.time_range()
+
+    def try_wait_next(self, sleep_duration=.1):
+        """
+        Waits at most sleep_duration seconds for a new value. It returns True if the time range has changed.
+        """
+        watcher = self.private_watcher(sleep_duration)
+        if self.private_changed():
+            return True
+        watcher.wait(sleep_duration)
+        return self.private_changed()
+        
         
     def wait_next(self, sleep_duration=.1):
-        dd = self.sync0
-        while self.sync0 == dd:
-            time.sleep(sleep_duration)
-            self.update()
-            dd = self.time_range()
+        """
+        Blocks until the time range changes. File change notifications
+        are used when available, sleep_duration is the polling period
+        otherwise.
+        """
+        watcher = self.private_watcher(sleep_duration)
+        while not self.private_changed():
+            watcher.wait()
 
     def listen(self, func, sleep_duration=.1):
-        dd = self.sync0
+        """
+        Calls func(self) each time the time range changes, forever.
+        """
+        watcher = self.private_watcher(sleep_duration)
         while True:
-            while self.sync0 == dd:
-                time.sleep(sleep_duration)
-                self.update()
-                dd = self.time_range()
-            self.sync0 = dd
+            while not self.private_changed():
+                watcher.wait()
             func(self)
 
 
@@ -344,6 +443,13 @@ def data_range_full(varpath):
     data.close()
     return
 
+def data_batch(varpath, first=None, last=None):
+    """
+    returns (times, ready_mask, values) arrays for [first, last], see Realize.batch.
+    """
+    with Realize(varpath) as data:
+        return data.batch(first, last)
+
 def data_range_lasts(varpath, nb):
     if nb <= 0:
         return
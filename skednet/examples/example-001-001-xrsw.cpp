@@ -25,7 +25,6 @@
 // The xrsw scheduler is a tcp/ip server that has to be started first.
 
 void process(sked::json::timeline& timeline, unsigned int id, const std::string& hostname, const std::string& port) {
-  asio::ip::tcp::iostream socket;
   std::random_device rd;
   std::mt19937 gen(rd());
   std::uniform_real_distribution<double> job_duration(1, 3);
@@ -33,8 +32,8 @@ void process(sked::json::timeline& timeline, unsigned int id, const std::string&
   sked::json::rgb write_color {.8, .2, .2};
   sked::json::rgb read_color  {.2, .8, .2};
   try {
-    socket.exceptions(std::ios::failbit | std::ios::badbit | std::ios::eofbit);
-    socket.connect(hostname, port);
+    auto p_socket = sked::net::endpoint::connect(hostname, port);
+    auto& socket = *p_socket;
 
     for(unsigned int i = 0; i < NB_ROUNDS; ++i)
       if(toss(gen) < WRITER_PROBA) {
@@ -54,7 +53,7 @@ void process(sked::json::timeline& timeline, unsigned int id, const std::string&
 int main(int argc, char* argv[]) {
 
   if(argc != 3) {
-    std::cout << "Usage: " << argv[0] << " <hostname> <port>" << std::endl
+    std::cout << "Usage: " << argv[0] << " <hostname> <port|unix:/path>" << std::endl
 	      << "       (start skednet-xrsw server beforehand)." << std::endl;
     return  0;
   }
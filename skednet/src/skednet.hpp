@@ -1,5 +1,6 @@
 #pragma once
 
 #include <skednetProtocol.hpp>
+#include <skednetEndpoint.hpp>
 #include <skednetScope.hpp>
 #include <skednetService.hpp>
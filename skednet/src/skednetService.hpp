@@ -2,6 +2,8 @@
 
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <iostream>
 
 #include <asio.hpp>
 #include <sked.hpp>
@@ -29,15 +31,20 @@ namespace sked {
      * @short This is what services have in common.
      */
     class core_service {
-      std::shared_ptr<asio::ip::tcp::iostream>  p_socket;
+      std::shared_ptr<std::iostream>  p_socket;
     public:
-      core_service(asio::ip::tcp::acceptor& acceptor) 
-	: p_socket(new asio::ip::tcp::iostream()) {
-	acceptor.accept(*(p_socket->rdbuf())); // Blocking is here
+      /**
+       * The acceptor is a tcp or a local one (see sked::net::endpoint).
+       */
+      template<typename ACCEPTOR>
+      core_service(ACCEPTOR& acceptor) {
+	auto socket = std::make_shared<typename ACCEPTOR::protocol_type::iostream>();
+	acceptor.accept(*(socket->rdbuf())); // Blocking is here
+	p_socket = socket;
       }
       
     protected:
-      asio::ip::tcp::iostream& socket() {return *p_socket;}
+      std::iostream& socket() {return *p_socket;}
     };
 
     namespace xrsw {
@@ -52,7 +59,8 @@ namespace sked {
 	
       public:
 
-	service(main& context, asio::ip::tcp::acceptor& acceptor) : core_service(acceptor), context(context) {}
+	template<typename ACCEPTOR>
+	service(main& context, ACCEPTOR& acceptor) : core_service(acceptor), context(context) {}
 	  
 	void operator()() {
 	  try {
@@ -14,20 +14,20 @@ using namespace std::literals::chrono_literals;
 int main(int argc, char* argv[]) {
 
   if(argc != 2) {
-    std::cout << "Usage: " << argv[0] << " <port>" << std::endl;
+    std::cout << "Usage: " << argv[0] << " <port|unix:/path>" << std::endl;
     return 0;
   }
   
   asio::io_service        ios;
   sked::net::xrsw::main context;
 
-  std::thread listen {[&ios, &context, port = std::stoi(argv[1])](){
-    asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
-    asio::ip::tcp::acceptor acceptor(ios, endpoint);
-    while(true) {
-      std::thread service {sked::net::xrsw::service(context, acceptor)};
-      service.detach();
-    }
+  std::thread listen {[&ios, &context, port = std::string(argv[1])](){
+    sked::net::endpoint::listen(ios, port, [&context](auto& acceptor) {
+	while(true) {
+	  std::thread service {sked::net::xrsw::service(context, acceptor)};
+	  service.detach();
+	}
+      });
   }};
 
   context.loop(500ms);